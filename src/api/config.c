@@ -77,6 +77,7 @@ static char       *l_UserCacheDirOverride = NULL;
 static char       *l_UserDataDirOverride = NULL;
 static config_list l_ConfigListActive = NULL;
 static config_list l_ConfigListSaved = NULL;
+static config_param *l_BoundParams = NULL;
 
 /* --------------- */
 /* local functions */
@@ -190,6 +191,81 @@ static config_var *find_section_var(config_section *section, const char *ParamNa
     return NULL;
 }
 
+/* Value strings of a bound parameter, newest first */
+typedef struct _param_string {
+  struct _param_string *next;
+  char                  value[1];
+  } param_string;
+
+/* Point a bound parameter at a copy of string.
+ * The old string isn't freed: another thread may still be reading it. */
+static void set_param_string(config_param *param, const char *string)
+{
+    param_string *node;
+    size_t len;
+
+    if (param->string != NULL && strcmp(param->string, string) == 0)
+        return;
+
+    len = strlen(string);
+    node = (param_string *) malloc(sizeof(param_string) + len);
+    if (node == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "Couldn't allocate value of bound parameter '%s'", param->name);
+        return;
+    }
+    memcpy(node->value, string, len + 1);
+    node->next = (param_string *) param->strings;
+    param->strings = node;
+    param->string = node->value;
+}
+
+/* Refresh the cached values of a bound parameter from the active list */
+static void refresh_param(config_param *param)
+{
+    config_section *section;
+    config_var *var = NULL;
+    const char *string = "";
+
+    section = find_section(l_ConfigListActive, param->section);
+    if (section != NULL)
+        var = find_section_var(section, param->name);
+
+    if (var == NULL)
+    {
+        param->integer = 0;
+        param->number = 0.0f;
+    }
+    else
+    {
+        param->integer = ConfigGetParamInt((m64p_handle) section, param->name);
+        param->number = ConfigGetParamFloat((m64p_handle) section, param->name);
+        string = ConfigGetParamString((m64p_handle) section, param->name);
+    }
+
+    set_param_string(param, string);
+
+    if (param->changed != NULL)
+        param->changed(param->opaque, param);
+}
+
+/* Refresh the bound parameters matching SectionName and ParamName.
+ * A NULL ParamName matches every parameter of the section. */
+static void notify_params(const char *SectionName, const char *ParamName)
+{
+    config_param *param;
+
+    for (param = l_BoundParams; param != NULL; param = param->next)
+    {
+        if (osal_insensitive_strcmp(param->section, SectionName) != 0)
+            continue;
+        if (ParamName != NULL && osal_insensitive_strcmp(param->name, ParamName) != 0)
+            continue;
+
+        refresh_param(param);
+    }
+}
+
 static void append_var_to_section(config_section *section, config_var *var)
 {
     config_var *last_var;
@@ -622,9 +698,68 @@ m64p_error ConfigShutdown(void)
     delete_list(&l_ConfigListActive);
     delete_list(&l_ConfigListSaved);
 
+    /* unbind the typed parameter handles */
+    while (l_BoundParams != NULL)
+        ConfigUnbindParam(l_BoundParams);
+
     return M64ERR_SUCCESS;
 }
 
+m64p_error ConfigBindParam(config_param *param, const char *SectionName, const char *ParamName)
+{
+    config_param *curr;
+
+    if (!l_ConfigInit)
+        return M64ERR_NOT_INIT;
+    if (param == NULL || SectionName == NULL || ParamName == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    /* a handle may be bound again, e.g. when the core defaults are reset */
+    for (curr = l_BoundParams; curr != NULL; curr = curr->next)
+    {
+        if (curr == param)
+            break;
+    }
+
+    param->section = SectionName;
+    param->name = ParamName;
+    if (curr == NULL)
+    {
+        param->string = "";
+        param->strings = NULL;
+        param->next = l_BoundParams;
+        l_BoundParams = param;
+    }
+
+    refresh_param(param);
+
+    return M64ERR_SUCCESS;
+}
+
+void ConfigUnbindParam(config_param *param)
+{
+    config_param **link;
+    param_string *node;
+
+    for (link = &l_BoundParams; *link != NULL; link = &(*link)->next)
+    {
+        if (*link == param)
+        {
+            *link = param->next;
+            break;
+        }
+    }
+
+    param->string = "";
+    while (param->strings != NULL)
+    {
+        node = (param_string *) param->strings;
+        param->strings = node->next;
+        free(node);
+    }
+    param->next = NULL;
+}
+
 /* ------------------------------------------------ */
 /* Selector functions, exported outside of the Core */
 /* ------------------------------------------------ */
@@ -949,6 +1084,8 @@ EXPORT m64p_error CALL ConfigDeleteSection(const char *SectionName)
     /* fix the pointer to point to the next section after the deleted one */
     *curr_section_link = next_section;
 
+    notify_params(SectionName, NULL);
+
     return M64ERR_SUCCESS;
 }
 
@@ -1040,6 +1177,8 @@ EXPORT m64p_error CALL ConfigRevertChanges(const char *SectionName)
     /* release memory associated with active_section */
     delete_section(active_section);
 
+    notify_params(SectionName, NULL);
+
     return M64ERR_SUCCESS;
 }
 
@@ -1106,6 +1245,8 @@ EXPORT m64p_error CALL ConfigSetParameter(m64p_handle ConfigSectionHandle, const
             break;
     }
 
+    notify_params(section->name, ParamName);
+
     return M64ERR_SUCCESS;
 }
 
@@ -22,9 +22,38 @@
 /* This file contains the Core configuration functions
  */
 
+#if !defined(API_CONFIG_H)
+#define API_CONFIG_H
+
 #include "m64p_types.h"
 
 /* these functions are only to be used within the Core library */
 
 m64p_error ConfigInit(const char *ConfigDirOverride, const char *DataDirOverride);
 m64p_error ConfigShutdown(void);
+
+/* Typed handle on a parameter, for lookups on hot paths.
+ *
+ * A bound handle caches the value of its parameter under each type, so that
+ * reading it costs a load instead of a walk through the config list.
+ * The cached values are refreshed whenever the parameter is changed through
+ * the config API, then the optional 'changed' callback is invoked.
+ * A new value gets a new string and the pointer is swapped, so a reader on
+ * another thread sees either the old or the new string, never a mix of both.
+ * Replaced strings stay valid until the handle is unbound. */
+typedef struct _config_param {
+  const char            *section;
+  const char            *name;
+  int                    integer;
+  float                  number;
+  const char            *string;
+  void                  *strings;
+  void                 (*changed)(void *opaque, const struct _config_param *param);
+  void                  *opaque;
+  struct _config_param  *next;
+  } config_param;
+
+m64p_error ConfigBindParam(config_param *param, const char *SectionName, const char *ParamName);
+void       ConfigUnbindParam(config_param *param);
+
+#endif /* API_CONFIG_H */
@@ -143,6 +143,37 @@ EXPORT int CALL DebugGetState(m64p_dbg_state statenum)
             return get_r4300_emumode(&g_dev.r4300);
         case M64P_DBG_CPU_NEXT_INTERRUPT:
             return *r4300_cp0_next_interrupt(&g_dev.r4300.cp0);
+#ifdef NEW_DYNAREC
+        case M64P_DBG_DYNAREC_BLOCKS_COMPILED:
+            return (int) new_dynarec_get_stats()->blocks_compiled;
+        case M64P_DBG_DYNAREC_KBYTES_EMITTED:
+            return (int) (new_dynarec_get_stats()->bytes_emitted >> 10);
+        case M64P_DBG_DYNAREC_BLOCKS_EXPIRED:
+            return (int) new_dynarec_get_stats()->blocks_expired;
+        case M64P_DBG_DYNAREC_INVALIDATIONS:
+            return (int) new_dynarec_get_stats()->invalidations;
+        case M64P_DBG_DYNAREC_DIRTY_HITS:
+            return (int) new_dynarec_get_stats()->dirty_hits;
+        case M64P_DBG_DYNAREC_DIRTY_MISSES:
+            return (int) new_dynarec_get_stats()->dirty_misses;
+        case M64P_DBG_DYNAREC_HT_FIRST_HITS:
+            return (int) new_dynarec_get_stats()->ht_hits[0];
+        case M64P_DBG_DYNAREC_HT_SECOND_HITS:
+            return (int) new_dynarec_get_stats()->ht_hits[1];
+        case M64P_DBG_DYNAREC_HT_MISSES:
+            return (int) new_dynarec_get_stats()->ht_misses;
+#else
+        case M64P_DBG_DYNAREC_BLOCKS_COMPILED:
+        case M64P_DBG_DYNAREC_KBYTES_EMITTED:
+        case M64P_DBG_DYNAREC_BLOCKS_EXPIRED:
+        case M64P_DBG_DYNAREC_INVALIDATIONS:
+        case M64P_DBG_DYNAREC_DIRTY_HITS:
+        case M64P_DBG_DYNAREC_DIRTY_MISSES:
+        case M64P_DBG_DYNAREC_HT_FIRST_HITS:
+        case M64P_DBG_DYNAREC_HT_SECOND_HITS:
+        case M64P_DBG_DYNAREC_HT_MISSES:
+            return 0;
+#endif
         default:
             DebugMessage(M64MSG_WARNING, "Bug: invalid m64p_dbg_state input in DebugGetState()");
             return 0;
@@ -214,6 +245,11 @@ EXPORT int CALL DebugMemGetMemInfo(m64p_dbg_mem_info mem_info_type, unsigned int
             return get_has_recompiled(r4300, address);
         case M64P_DBG_MEM_NUM_RECOMPILED:
             return get_num_recompiled(r4300, address);
+        case M64P_DBG_MEM_NUM_INVALIDATIONS:
+            if ((address & UINT32_C(0xc0000000)) != UINT32_C(0x80000000)
+             || (address & UINT32_C(0x1fffffff)) >= UINT32_C(0x800000))
+                return 0;
+            return (int) r4300->cached_interp.invalidations[(address >> 12) & 0x7ff];
         default:
             DebugMessage(M64MSG_ERROR, "Bug: DebugMemGetMemInfo() called with invalid m64p_dbg_mem_info");
             return 0;
@@ -46,6 +46,7 @@
 #include "main/workqueue.h"
 #include "main/screenshot.h"
 #include "main/netplay.h"
+#include "osal/memory.h"
 #include "plugin/plugin.h"
 #include "vidext.h"
 
@@ -97,6 +98,7 @@ EXPORT m64p_error CALL CoreStartup(int APIVersion, const char *ConfigPath, const
         return M64ERR_INTERNAL;
 
     /* allocate base memory */
+    osal_set_large_pages(ConfigGetParamInt(g_CoreConfig, "LargePages"));
     g_mem_base = init_mem_base();
     if (g_mem_base == NULL) {
         return M64ERR_NO_MEMORY;
@@ -189,6 +191,19 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
                 cheat_init(&g_cheat_ctx);
             }
             return rval;
+        case M64CMD_ROM_OPEN_FILE:
+            if (g_EmulatorRunning || l_ROMOpen)
+                return M64ERR_INVALID_STATE;
+            if (ParamPtr == NULL)
+                return M64ERR_INPUT_ASSERT;
+            rval = open_rom_file((const char *) ParamPtr);
+            if (rval == M64ERR_SUCCESS)
+            {
+                l_ROMOpen = 1;
+                ScreenshotRomOpen();
+                cheat_init(&g_cheat_ctx);
+            }
+            return rval;
         case M64CMD_ROM_CLOSE:
             if (g_EmulatorRunning || !l_ROMOpen)
                 return M64ERR_INVALID_STATE;
@@ -301,6 +316,15 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
                 return M64ERR_INVALID_STATE;
             main_take_next_screenshot();
             return M64ERR_SUCCESS;
+        case M64CMD_RENDER_NEXT_FRAME:
+            if (!g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            main_render_next_frame();
+            return M64ERR_SUCCESS;
+        case M64CMD_GET_PACING_SAMPLES:
+            if (ParamPtr == NULL)
+                return M64ERR_INPUT_ASSERT;
+            return main_get_pacing_samples((m64p_pacing_sample *) ParamPtr, ParamInt);
         case M64CMD_READ_SCREEN:
             if (!g_EmulatorRunning)
                 return M64ERR_INVALID_STATE;
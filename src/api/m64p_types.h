@@ -168,7 +168,10 @@ typedef enum {
   M64CMD_NETPLAY_GET_VERSION,
   M64CMD_NETPLAY_CLOSE,
   M64CMD_PIF_OPEN,
-  M64CMD_ROM_SET_SETTINGS
+  M64CMD_ROM_SET_SETTINGS,
+  M64CMD_ROM_OPEN_FILE,
+  M64CMD_RENDER_NEXT_FRAME,
+  M64CMD_GET_PACING_SAMPLES
 } m64p_command;
 
 typedef struct {
@@ -267,6 +270,15 @@ typedef struct
    unsigned int sidmaduration; /* Default SI DMA duration */
 } m64p_rom_settings;
 
+/* Frame pacing telemetry, one sample per VI (see M64CMD_GET_PACING_SAMPLES) */
+typedef struct
+{
+   unsigned int vi;       /* VI sequence number, starting at 1. 0 for an empty sample. */
+   int64_t emulation_ns;  /* Time spent since the previous VI was paced. */
+   int64_t sleep_ns;      /* Time spent waiting for this VI to be due. */
+   int64_t overshoot_ns;  /* How late this VI was paced past its due time. */
+} m64p_pacing_sample;
+
 /* ----------------------------------------- */
 /* Structures and Types for the Debugger     */
 /* ----------------------------------------- */
@@ -276,7 +288,16 @@ typedef enum {
   M64P_DBG_PREVIOUS_PC,
   M64P_DBG_NUM_BREAKPOINTS,
   M64P_DBG_CPU_DYNACORE,
-  M64P_DBG_CPU_NEXT_INTERRUPT
+  M64P_DBG_CPU_NEXT_INTERRUPT,
+  M64P_DBG_DYNAREC_BLOCKS_COMPILED,
+  M64P_DBG_DYNAREC_KBYTES_EMITTED,
+  M64P_DBG_DYNAREC_BLOCKS_EXPIRED,
+  M64P_DBG_DYNAREC_INVALIDATIONS,
+  M64P_DBG_DYNAREC_DIRTY_HITS,
+  M64P_DBG_DYNAREC_DIRTY_MISSES,
+  M64P_DBG_DYNAREC_HT_FIRST_HITS,
+  M64P_DBG_DYNAREC_HT_SECOND_HITS,
+  M64P_DBG_DYNAREC_HT_MISSES
 } m64p_dbg_state;
 
 typedef enum {
@@ -290,6 +311,7 @@ typedef enum {
   M64P_DBG_MEM_FLAGS,
   M64P_DBG_MEM_HAS_RECOMPILED,
   M64P_DBG_MEM_NUM_RECOMPILED,
+  M64P_DBG_MEM_NUM_INVALIDATIONS,
   M64P_DBG_RECOMP_OPCODE = 16,
   M64P_DBG_RECOMP_ARGS,
   M64P_DBG_RECOMP_ADDR
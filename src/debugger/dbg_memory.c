@@ -128,7 +128,7 @@ static void decode_recompiled(struct r4300_core* r4300, uint32_t addr)
 
     lines_recompiled=0;
 
-    if (r4300->cached_interp.blocks[addr>>12] == NULL)
+    if (r4300->cached_interp.blocks == NULL || r4300->cached_interp.blocks[addr>>12] == NULL)
         return;
 
     if (r4300->cached_interp.blocks[addr>>12]->block[(addr&0xFFF)/4].ops == r4300->cached_interp.not_compiled)
@@ -209,7 +209,7 @@ int get_has_recompiled(struct r4300_core* r4300, uint32_t addr)
 {
     unsigned char *assemb, *end_addr;
 
-    if (r4300->emumode != EMUMODE_DYNAREC || r4300->cached_interp.blocks[addr>>12] == NULL)
+    if (r4300->emumode != EMUMODE_DYNAREC || r4300->cached_interp.blocks == NULL || r4300->cached_interp.blocks[addr>>12] == NULL)
         return FALSE;
 
     assemb = (r4300->cached_interp.blocks[addr>>12]->code) +
@@ -359,7 +359,7 @@ uint32_t get_memory_flags(struct device* dev, uint32_t addr)
     switch(type)
     {
         case M64P_MEM_NOMEM:
-            if(dev->r4300.cp0.tlb.LUT_r[addr>>12])
+            if(tlb_lut_get(&dev->r4300.cp0.tlb.LUT_r, addr>>12))
                 flags = M64P_MEM_FLAG_READABLE | M64P_MEM_FLAG_WRITABLE_EMUONLY;
             break;
         case M64P_MEM_NOTHING:
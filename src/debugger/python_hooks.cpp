@@ -1,7 +1,11 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <dirent.h>
 
+#include <algorithm>
+#include <map>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include <fstream>
@@ -19,6 +23,9 @@
 extern "C" {
 #include "device/r4300/r4300_core.h"
 #include "device/rdram/rdram.h"
+#include "main/forkserver.h"
+#include "main/main.h"
+#include "plugin/headless_input.h"
 #include "plugin/plugin.h"
 }
 
@@ -27,9 +34,6 @@ using namespace pybind11::literals;
 
 PYBIND11_MAKE_OPAQUE(std::vector<uint64_t>);
 
-char g_run_button_hooks = false;
-static uint32_t nextCookie;
-
 struct Hook {
     py::function callback;
     uint32_t cookie;
@@ -42,40 +46,112 @@ struct RangeHook {
     uint32_t cookie;
 };
 
-static std::map<uint32_t, std::vector<Hook> > all_pc_hooks;
+/* Hooks registered by the scripts of one emulator instance */
+struct HookTables {
+    struct r4300_core* r4300 = NULL;
+
+    uint32_t nextCookie = 0;
+
+    std::map<uint32_t, std::vector<Hook> > pc_hooks;
+
+    std::map<uint32_t, std::vector<Hook> > button_hooks;
+
+    std::vector<RangeHook> ram_read_hooks;
+    std::vector<RangeHook> ram_write_hooks;
+
+    std::vector<RangeHook> cart_read_hooks;
+    std::vector<RangeHook> cart_write_hooks;
+};
+
+/* Tables of the instance whose scripts or hooks are running on this thread.
+ * The register/remove functions exposed to python operate on them. */
+static thread_local HookTables* current_tables = NULL;
 
-static std::map<uint32_t, std::vector<Hook> > all_button_hooks;
+class TablesScope {
+    public:
+        TablesScope(HookTables* tables) {
+            previous = current_tables;
+            current_tables = tables;
+        }
 
-static std::vector<RangeHook> all_ram_read_hooks;
-static std::vector<RangeHook> all_ram_write_hooks;
+        ~TablesScope() {
+            current_tables = previous;
+        }
 
-static std::vector<RangeHook> all_cart_read_hooks;
-static std::vector<RangeHook> all_cart_write_hooks;
+    private:
+        HookTables* previous;
+};
+
+static inline HookTables* tablesOf(struct r4300_core* r4300) {
+    return (r4300 == NULL) ? NULL : (HookTables*) r4300->hooks.tables;
+}
+
+static HookTables& currentTables() {
+    if (current_tables == NULL) {
+        throw std::runtime_error("hooks can only be changed from hook scripts or hook callbacks");
+    }
+    return *current_tables;
+}
+
+/* Flags the RDRAM pages which a range hook covers through KSEG0 */
+static void markRamPages(uint8_t* pages, const std::vector<RangeHook>& hooks, uint8_t kind) {
+    for (const RangeHook& hook : hooks) {
+        uint32_t min = std::max(hook.min, R4300_KSEG0);
+        uint32_t max = std::min(hook.max, R4300_KSEG0 + 0x800000);
+        for (uint32_t addr = min & ~UINT32_C(0xfff); addr < max; addr += 0x1000) {
+            pages[(addr - R4300_KSEG0) >> 12] |= kind;
+        }
+    }
+}
+
+/* Tells the core which kinds of hooks are registered,
+ * the others are skipped without calling into this layer. */
+static void updateActiveHooks(HookTables& t) {
+    unsigned int active = 0;
+
+    if (!t.pc_hooks.empty()) active |= R4300_HOOK_PC;
+    if (!t.button_hooks.empty()) active |= R4300_HOOK_BUTTON;
+    if (!t.ram_read_hooks.empty()) active |= R4300_HOOK_RAM_READ;
+    if (!t.ram_write_hooks.empty()) active |= R4300_HOOK_RAM_WRITE;
+    if (!t.cart_read_hooks.empty()) active |= R4300_HOOK_CART_READ;
+    if (!t.cart_write_hooks.empty()) active |= R4300_HOOK_CART_WRITE;
+
+    t.r4300->hooks.active = active;
+
+    uint8_t pages[sizeof(t.r4300->hooks.ram_pages)] = {0};
+    markRamPages(pages, t.ram_read_hooks, R4300_HOOK_RAM_READ);
+    markRamPages(pages, t.ram_write_hooks, R4300_HOOK_RAM_WRITE);
+
+    if (memcmp(pages, t.r4300->hooks.ram_pages, sizeof(pages)) != 0) {
+        memcpy(t.r4300->hooks.ram_pages, pages, sizeof(pages));
+        r4300_ram_hooks_changed(t.r4300);
+    }
+}
 
 // TODO: mark hooks for removal rather than doing it automatically
 // TODO: accept a True/False return value from hook that determines
 //       whether to delete it or not
 
 uint32_t registerButtonHook(uint32_t buttons, py::function callback) {
-    auto button_hooks = all_button_hooks[buttons];
-    button_hooks.push_back({callback, nextCookie});
-    all_button_hooks[buttons] = button_hooks;
-    nextCookie += 1;
+    HookTables& t = currentTables();
+    t.button_hooks[buttons].push_back({callback, t.nextCookie});
+    t.nextCookie += 1;
+    updateActiveHooks(t);
     printf("Registered hook %s for button combination 0x%08X\n", std::string(py::str(callback.attr("__name__"))).c_str(), buttons);
-    return nextCookie - 1;
+    return t.nextCookie - 1;
 }
 
 void removeButtonHook(uint32_t cookie) {
-    for (auto &pair : all_button_hooks) {
+    HookTables& t = currentTables();
+    for (auto &pair : t.button_hooks) {
         for (auto it = pair.second.begin(); it != pair.second.end(); it++) {
             if (it->cookie == cookie) {
                 printf("Removed hook %s for button combination 0x%08X\n", std::string(py::str(it->callback.attr("__name__"))).c_str(), pair.first);
                 pair.second.erase(it);
                 if (pair.second.size() == 0) {
-                    all_button_hooks.erase(pair.first);
-                } else {
-                    all_button_hooks[pair.first] = pair.second;
+                    t.button_hooks.erase(pair.first);
                 }
+                updateActiveHooks(t);
                 return;
             }        
         }
@@ -83,99 +159,114 @@ void removeButtonHook(uint32_t cookie) {
 }
 
 uint32_t registerPCHook(uint32_t pc, py::function callback) {
-    auto pc_hooks = all_pc_hooks[pc];
-    pc_hooks.push_back({callback, nextCookie});
-    all_pc_hooks[pc] = pc_hooks;
-    nextCookie += 1;
+    HookTables& t = currentTables();
+    t.pc_hooks[pc].push_back({callback, t.nextCookie});
+    t.nextCookie += 1;
+    updateActiveHooks(t);
     printf("Registered hook %s at PC 0x%08X\n", std::string(py::str(callback.attr("__name__"))).c_str(), pc);
-    return nextCookie - 1;
+    return t.nextCookie - 1;
 }
 
 void removePCHook(uint32_t cookie) {
-    for (auto &pair : all_pc_hooks) {
+    HookTables& t = currentTables();
+    for (auto &pair : t.pc_hooks) {
         for (auto it = pair.second.begin(); it != pair.second.end(); it++) {
             if (it->cookie == cookie) {
                 printf("Removed hook %s at PC 0x%08X\n", std::string(py::str(it->callback.attr("__name__"))).c_str(), pair.first);
                 pair.second.erase(it);
                 if (pair.second.size() == 0) {
-                    all_pc_hooks.erase(pair.first);
-                } else {
-                    all_pc_hooks[pair.first] = pair.second;
+                    t.pc_hooks.erase(pair.first);
                 }
+                updateActiveHooks(t);
                 return;
             }        
         }
     }
 }
 
-uint32_t registerCartReadHook(uint32_t addr_min, uint32_t addr_max, py::function callback) {
-    all_cart_read_hooks.push_back({addr_min, addr_max, callback, nextCookie});
-    nextCookie += 1;
-    printf("Registered hook %s for reads in cart range [0x%08X - 0x%08X) \n", std::string(py::str(callback.attr("__name__"))).c_str(), addr_min, addr_max);
-    return nextCookie - 1;
+static uint32_t registerRangeHook(std::vector<RangeHook>& hooks, const char* kind, uint32_t addr_min, uint32_t addr_max, py::function callback) {
+    HookTables& t = currentTables();
+    hooks.push_back({addr_min, addr_max, callback, t.nextCookie});
+    t.nextCookie += 1;
+    updateActiveHooks(t);
+    printf("Registered hook %s for %s [0x%08X - 0x%08X) \n", std::string(py::str(callback.attr("__name__"))).c_str(), kind, addr_min, addr_max);
+    return t.nextCookie - 1;
 }
 
-void removeCartReadHook(uint32_t cookie) {
-    for (auto it = all_cart_read_hooks.begin(); it != all_cart_read_hooks.end(); it++) {
+static void removeRangeHook(std::vector<RangeHook>& hooks, const char* kind, uint32_t cookie) {
+    HookTables& t = currentTables();
+    for (auto it = hooks.begin(); it != hooks.end(); it++) {
         if (it->cookie == cookie) {
-            printf("Removed hook %s for reads in cart range [0x%08X - 0x%08X)\n", std::string(py::str(it->callback.attr("__name__"))).c_str(), it->min, it->max);
-            all_cart_read_hooks.erase(it);
+            printf("Removed hook %s for %s [0x%08X - 0x%08X)\n", std::string(py::str(it->callback.attr("__name__"))).c_str(), kind, it->min, it->max);
+            hooks.erase(it);
+            updateActiveHooks(t);
             return;
         }        
     }
 }
 
-uint32_t registerRAMReadHook(uint32_t addr_min, uint32_t addr_max, py::function callback) {
-    all_ram_read_hooks.push_back({addr_min, addr_max, callback, nextCookie});
-    nextCookie += 1;
-    printf("Registered hook %s for reads in RAM range [0x%08X - 0x%08X) \n", std::string(py::str(callback.attr("__name__"))).c_str(), addr_min, addr_max);
-    return nextCookie - 1;
+uint32_t registerCartReadHook(uint32_t addr_min, uint32_t addr_max, py::function callback) {
+    return registerRangeHook(currentTables().cart_read_hooks, "reads in cart range", addr_min, addr_max, callback);
 }
 
+void removeCartReadHook(uint32_t cookie) {
+    removeRangeHook(currentTables().cart_read_hooks, "reads in cart range", cookie);
+}
+
+uint32_t registerRAMReadHook(uint32_t addr_min, uint32_t addr_max, py::function callback) {
+    return registerRangeHook(currentTables().ram_read_hooks, "reads in RAM range", addr_min, addr_max, callback);
+}
 
 void removeRAMReadHook(uint32_t cookie) {
-    for (auto it = all_ram_read_hooks.begin(); it != all_ram_read_hooks.end(); it++) {
-        if (it->cookie == cookie) {
-            printf("Removed hook %s for reads in RAM range [0x%08X - 0x%08X)\n", std::string(py::str(it->callback.attr("__name__"))).c_str(), it->min, it->max);
-            all_ram_read_hooks.erase(it);
-            return;
-        }        
-    }
+    removeRangeHook(currentTables().ram_read_hooks, "reads in RAM range", cookie);
 }
 
 uint32_t registerCartWriteHook(uint32_t addr_min, uint32_t addr_max, py::function callback) {
-    all_cart_write_hooks.push_back({addr_min, addr_max, callback, nextCookie});
-    nextCookie += 1;
-    printf("Registered hook %s for writes in cart range [0x%08X - 0x%08X) \n", std::string(py::str(callback.attr("__name__"))).c_str(), addr_min, addr_max);
-    return nextCookie - 1;
+    return registerRangeHook(currentTables().cart_write_hooks, "writes in cart range", addr_min, addr_max, callback);
 }
 
 void removeCartWriteHook(uint32_t cookie) {
-    for (auto it = all_cart_write_hooks.begin(); it != all_cart_write_hooks.end(); it++) {
-        if (it->cookie == cookie) {
-            printf("Removed hook %s for reads in cart range [0x%08X - 0x%08X)\n", std::string(py::str(it->callback.attr("__name__"))).c_str(), it->min, it->max);
-            all_cart_write_hooks.erase(it);
-            return;
-        }        
-    }
+    removeRangeHook(currentTables().cart_write_hooks, "writes in cart range", cookie);
 }
 
-
 uint32_t registerRAMWriteHook(uint32_t addr_min, uint32_t addr_max, py::function callback) {
-    all_ram_write_hooks.push_back({addr_min, addr_max, callback, nextCookie});
-    nextCookie += 1;
-    printf("Registered hook %s for writes in RAM range [0x%08X - 0x%08X) \n", std::string(py::str(callback.attr("__name__"))).c_str(), addr_min, addr_max);
-    return nextCookie - 1;
+    return registerRangeHook(currentTables().ram_write_hooks, "writes in RAM range", addr_min, addr_max, callback);
 }
 
 void removeRAMWriteHook(uint32_t cookie) {
-    for (auto it = all_ram_write_hooks.begin(); it != all_ram_write_hooks.end(); it++) {
-        if (it->cookie == cookie) {
-            printf("Removed hook %s for reads in RAM range [0x%08X - 0x%08X)\n", std::string(py::str(it->callback.attr("__name__"))).c_str(), it->min, it->max);
-            all_ram_write_hooks.erase(it);
-            return;
-        }        
+    removeRangeHook(currentTables().ram_write_hooks, "writes in RAM range", cookie);
+}
+
+/* Call hooks are native, so they run without entering python at all */
+void registerCallHookPrint(uint32_t target, uint32_t addr) {
+    struct call_hook hook = {};
+    hook.target = target;
+    hook.action = CALL_HOOK_PRINT_STRING;
+    hook.addr = addr;
+    if (!call_hooks_add(&currentTables().r4300->hooks.call_hooks, &hook)) {
+        throw std::bad_alloc();
     }
+    printf("Registered call hook at 0x%08X printing string at 0x%08X\n", target, addr);
+}
+
+void registerCallHookSetReg(uint32_t target, uint32_t reg, int64_t value) {
+    struct call_hook hook = {};
+    if (reg == 0 || reg >= 32) {
+        throw std::out_of_range("register must be in range 1-31");
+    }
+    hook.target = target;
+    hook.action = CALL_HOOK_SET_REG;
+    hook.reg = reg;
+    hook.value = value;
+    if (!call_hooks_add(&currentTables().r4300->hooks.call_hooks, &hook)) {
+        throw std::bad_alloc();
+    }
+    printf("Registered call hook at 0x%08X setting r%u\n", target, reg);
+}
+
+void removeCallHooks(uint32_t target) {
+    call_hooks_remove(&currentTables().r4300->hooks.call_hooks, target);
+    printf("Removed call hooks at 0x%08X\n", target);
 }
 
 
@@ -300,6 +391,20 @@ PYBIND11_EMBEDDED_MODULE(mupen_core, m) {
     m.def("registerCartWriteHook", &registerCartWriteHook, "Register a callback for writes within a cartride address range");
     m.def("removeCartWriteHook", &removeCartWriteHook, "Remove a callback for writes within a cartride address range");
 
+    m.def("registerCallHookPrint", &registerCallHookPrint, "Print the guest string at an address whenever a function is called");
+    m.def("registerCallHookSetReg", &registerCallHookSetReg, "Set a register whenever a function is called");
+    m.def("removeCallHooks", &removeCallHooks, "Remove the call hooks of a function");
+
+    m.def("getJobArgs", &fork_server_job_args, "Get the arguments of the current fork server job");
+    m.def("setJobResult", &fork_server_set_result, "Set the result reported when the current fork server job completes");
+
+    m.def("renderNextFrame", &main_render_next_frame, "Render the next frame whatever the render skip policy");
+
+    m.def("queueInput", [](int control, const std::vector<uint32_t>& buttons) {
+        return headlessinput_queue(control, buttons.data(), buttons.size()) != 0;
+    }, "Queue per-frame BUTTONS values for a controller of the headless input plugin");
+    m.def("clearInput", &headlessinput_clear, "Drop the queued inputs of a controller of the headless input plugin");
+
     py::bind_vector<std::vector<uint64_t>>(m, "RegsVector");
 
     py::class_<CoreState>(m, "CoreState")
@@ -324,106 +429,156 @@ PYBIND11_EMBEDDED_MODULE(mupen_core, m) {
 }
 
 
-static inline void runRangeHooks(struct r4300_core* r4300, uint32_t address, std::vector<RangeHook>& hooks, uint64_t value, uint64_t mask) {
-    if (hooks.size() == 0 || r4300 == NULL) {
+/* Hooks are collected before being called, so that callbacks can
+ * register or remove hooks without invalidating the iteration. */
+static inline void callHooks(struct r4300_core* r4300, const std::vector<py::function>& callbacks, py::args args) {
+    CoreState state {r4300};
+
+    for (auto &callback : callbacks) {
+        callback(&state, *args);
+    }
+
+    state.commit();
+}
+
+static inline void runRangeHooks(struct r4300_core* r4300, uint32_t address, std::vector<RangeHook> HookTables::* table, uint64_t value, uint64_t mask) {
+    HookTables* tables = tablesOf(r4300);
+    if (tables == NULL || (tables->*table).size() == 0) {
         return;
     }
 
-    CoreState state {r4300};
+    const std::vector<RangeHook>& hooks = tables->*table;
+    auto match = [address](const RangeHook& hook) { return address >= hook.min && address < hook.max; };
+    if (std::none_of(hooks.begin(), hooks.end(), match)) {
+        return;
+    }
 
-    for (auto hook : hooks) {
-        if (address >= hook.min && address < hook.max) {
-            hook.callback(&state, address, value, mask);
+    py::gil_scoped_acquire gil;
+    TablesScope scope {tables};
+    std::vector<py::function> callbacks;
+    for (auto &hook : hooks) {
+        if (match(hook)) {
+            callbacks.push_back(hook.callback);
         }
     }
 
-    state.commit();
+    callHooks(r4300, callbacks, py::make_tuple(address, value, mask));
 }
 
 extern "C" void pyRunRamReadHooks(struct r4300_core* r4300, uint32_t address) {
-    runRangeHooks(r4300, address, all_ram_read_hooks, 0, 0);
+    runRangeHooks(r4300, address, &HookTables::ram_read_hooks, 0, 0);
 }
 
 
 extern "C" void pyRunRamWriteHooks(struct r4300_core* r4300, uint32_t address, uint64_t value, uint64_t mask) {
-    runRangeHooks(r4300, address, all_ram_write_hooks, value, mask);
+    runRangeHooks(r4300, address, &HookTables::ram_write_hooks, value, mask);
 }
 
 
-static inline void runDMAHooks(struct r4300_core* r4300, uint32_t base, uint32_t len, uint32_t dst, std::vector<RangeHook>& hooks) {
-    if (hooks.size() == 0 || r4300 == NULL) {
+static inline void runDMAHooks(struct r4300_core* r4300, uint32_t base, uint32_t len, uint32_t dst, std::vector<RangeHook> HookTables::* table) {
+    HookTables* tables = tablesOf(r4300);
+    if (tables == NULL || (tables->*table).size() == 0) {
         return;
     }
 
-    CoreState state {r4300};
-
-    for (auto hook : hooks) {
+    py::gil_scoped_acquire gil;
+    TablesScope scope {tables};
+    std::vector<py::function> callbacks;
+    for (auto &hook : tables->*table) {
         if (base < hook.max && base + len > hook.min) {
-            hook.callback(&state, base, len, dst);
+            callbacks.push_back(hook.callback);
         }
     }
 
-    state.commit();
+    if (callbacks.size() != 0) {
+        callHooks(r4300, callbacks, py::make_tuple(base, len, dst));
+    }
 }
 
 extern "C" void pyRunCartReadHooks(struct r4300_core* r4300, uint32_t base, uint32_t len, uint32_t dst) {
-    runDMAHooks(r4300, base, len, dst, all_cart_read_hooks);
+    runDMAHooks(r4300, base, len, dst, &HookTables::cart_read_hooks);
 }
 
 
 extern "C" void pyRunCartWriteHooks(struct r4300_core* r4300, uint32_t base, uint32_t len, uint32_t dst) {
-    runDMAHooks(r4300, base, len, dst, all_cart_write_hooks);
+    runDMAHooks(r4300, base, len, dst, &HookTables::cart_write_hooks);
 }
 
 extern "C" void pyRunPCHooks(struct r4300_core* r4300) {
-    if (r4300 == NULL) {
+    HookTables* tables = tablesOf(r4300);
+    if (tables == NULL) {
         return;
     }
 
     uint32_t pc = r4300->interp_PC.addr; // *r4300_pc(r4300);
-    auto it = all_pc_hooks.find(pc);
-    if (it == all_pc_hooks.end()) {
+    auto it = tables->pc_hooks.find(pc);
+    if (it == tables->pc_hooks.end()) {
         return;
     }
 
-    CoreState state {r4300};
-
-    for (auto &hook : it->second){
-        hook.callback(&state);
+    py::gil_scoped_acquire gil;
+    TablesScope scope {tables};
+    std::vector<py::function> callbacks;
+    for (auto &hook : it->second) {
+        callbacks.push_back(hook.callback);
     }
 
-    state.commit();
+    callHooks(r4300, callbacks, py::make_tuple());
 }
 
 extern "C" void pyRunButtonHooks(struct r4300_core* r4300) {
-    if (r4300 == NULL || all_button_hooks.size() == 0) {
+    HookTables* tables = tablesOf(r4300);
+    if (tables == NULL || tables->button_hooks.size() == 0) {
         return;
     }
 
     BUTTONS buttons;
     buttons.Value = 0;
     input.getKeys(0, &buttons);
-    CoreState state {r4300};
 
-    for (auto hook_list : all_button_hooks) {
+    py::gil_scoped_acquire gil;
+    TablesScope scope {tables};
+    std::vector<py::function> callbacks;
+    for (auto &hook_list : tables->button_hooks) {
         if ((hook_list.first & buttons.Value) == buttons.Value) {
-            for (auto hook : hook_list.second) {
-                hook.callback(&state);
+            for (auto &hook : hook_list.second) {
+                callbacks.push_back(hook.callback);
             }
         }
     }
 
-    state.commit();
+    callHooks(r4300, callbacks, py::make_tuple());
+}
+
+static PyGILState_STATE fork_gil_state;
+
+extern "C" void pyBeforeFork(void) {
+    if (Py_IsInitialized()) {
+        fork_gil_state = PyGILState_Ensure();
+        PyOS_BeforeFork();
+    }
+}
+
+extern "C" void pyAfterForkParent(void) {
+    if (Py_IsInitialized()) {
+        PyOS_AfterFork_Parent();
+        PyGILState_Release(fork_gil_state);
+    }
+}
+
+extern "C" void pyAfterForkChild(void) {
+    if (Py_IsInitialized()) {
+        PyOS_AfterFork_Child();
+        PyGILState_Release(fork_gil_state);
+    }
 }
 
-extern "C" void pyLoadHooks(const char *path) {
+extern "C" void pyLoadHooks(struct r4300_core* r4300, const char *path) {
 
     printf("Scanning %s for hooks\n", path);
     struct dirent *entry;
     DIR *dp;
 
-    nextCookie = 0;
-
     std::vector<std::string> hookFiles;
     dp = opendir(path);
     if (dp == NULL) {
@@ -438,9 +593,28 @@ extern "C" void pyLoadHooks(const char *path) {
     // TODO: only run files ending in '.py'
     std::sort(hookFiles.begin(), hookFiles.end());
 
-    // py::scoped_interpreter python_interpreter{};
-    py::initialize_interpreter();
-    
+    /* The interpreter is shared by all emulator instances of the process.
+     * Each instance takes the GIL only while it runs python code. */
+    if (!Py_IsInitialized()) {
+        py::initialize_interpreter();
+        PyEval_SaveThread();
+    }
+
+    py::gil_scoped_acquire gil;
+
+    HookTables* tables = tablesOf(r4300);
+    if (tables != NULL) {
+        delete tables;
+    }
+    tables = new HookTables();
+    tables->r4300 = r4300;
+    r4300->hooks.tables = tables;
+    r4300->hooks.active = 0;
+    memset(r4300->hooks.ram_pages, 0, sizeof(r4300->hooks.ram_pages));
+    r4300_ram_hooks_changed(r4300);
+
+    TablesScope scope {tables};
+
     auto py_sys = py::module::import("sys");
     py_sys.attr("path").attr("append")(py::str(path));
 
@@ -455,4 +629,18 @@ extern "C" void pyLoadHooks(const char *path) {
         printf("Imported %s\n", filename.c_str());
     }
 
-}
\ No newline at end of file
+}
+
+extern "C" void pyReleaseHooks(struct r4300_core* r4300) {
+    HookTables* tables = tablesOf(r4300);
+    if (tables == NULL) {
+        return;
+    }
+
+    py::gil_scoped_acquire gil;
+    delete tables;
+    r4300->hooks.tables = NULL;
+    r4300->hooks.active = 0;
+    memset(r4300->hooks.ram_pages, 0, sizeof(r4300->hooks.ram_pages));
+    r4300_ram_hooks_changed(r4300);
+}
@@ -4,7 +4,11 @@ struct r4300_core;
 extern "C" {
 #endif
 
-void pyLoadHooks(const char *path);
+void pyLoadHooks(struct r4300_core* r4300, const char *path);
+void pyReleaseHooks(struct r4300_core* r4300);
+void pyBeforeFork(void);
+void pyAfterForkParent(void);
+void pyAfterForkChild(void);
 void pyRunPCHooks(struct r4300_core* r4300);
 void pyRunButtonHooks(struct r4300_core* r4300);
 void pyRunRamReadHooks(struct r4300_core* r4300, uint32_t address);
@@ -12,8 +16,6 @@ void pyRunRamWriteHooks(struct r4300_core* r4300, uint32_t address, uint64_t val
 void pyRunCartReadHooks(struct r4300_core* r4300, uint32_t base, uint32_t len, uint32_t dst);
 void pyRunCartWriteHooks(struct r4300_core* r4300, uint32_t base, uint32_t len, uint32_t dst);
 
-extern char g_run_button_hooks;
-
 #ifdef __cplusplus
 }
 #endif
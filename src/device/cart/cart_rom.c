@@ -86,43 +86,44 @@ void write_cart_rom(void* opaque, uint32_t address, uint32_t value, uint32_t mas
 }
 
 
-extern char cart_dma_read_trigger;
-extern char cart_dma_write_trigger;
-extern uint32_t cart_dma_dram;
-extern uint32_t cart_dma_base;
-extern uint32_t cart_dma_len;
-
 unsigned int cart_rom_dma_read(void* opaque, const uint8_t* dram, uint32_t dram_addr, uint32_t cart_addr, uint32_t length)
 {
+    struct cart_rom* cart_rom = (struct cart_rom*)opaque;
+    struct r4300_hooks* hooks = &cart_rom->r4300->hooks;
+
     cart_addr &= CART_ROM_ADDR_MASK;
 
     // printf("DMA RD %08X %d bytes from %08X \n", cart_addr, length, dram_addr);
 
-    cart_dma_read_trigger = 1;
-    cart_dma_base = cart_addr;
-    cart_dma_len = length;
-    cart_dma_dram = dram_addr;
+    /* DMA write -> cartridge read */
+    if (hooks->active & R4300_HOOK_CART_WRITE) {
+        hooks->cart_dma_read_pending = 1;
+        hooks->cart_dma_base = cart_addr;
+        hooks->cart_dma_len = length;
+        hooks->cart_dma_dram = dram_addr;
+    }
 
     DebugMessage(M64MSG_WARNING, "DMA Writing to CART_ROM: 0x%" PRIX32 " -> 0x%" PRIX32 " (0x%" PRIX32 ")", dram_addr, cart_addr, length);
 
     return /* length / 8 */0x1000;
 }
 
-extern uint32_t addr_log_min;
-extern uint32_t addr_log_max;
-
 unsigned int cart_rom_dma_write(void* opaque, uint8_t* dram, uint32_t dram_addr, uint32_t cart_addr, uint32_t length)
 {
     size_t i;
     struct cart_rom* cart_rom = (struct cart_rom*)opaque;
     const uint8_t* mem = cart_rom->rom;
+    struct r4300_hooks* hooks = &cart_rom->r4300->hooks;
 
     cart_addr &= CART_ROM_ADDR_MASK;
 
-    cart_dma_write_trigger = 1;
-    cart_dma_base = cart_addr;
-    cart_dma_len = length;
-    cart_dma_dram = dram_addr;
+    /* DMA read -> cartridge write */
+    if (hooks->active & R4300_HOOK_CART_READ) {
+        hooks->cart_dma_write_pending = 1;
+        hooks->cart_dma_base = cart_addr;
+        hooks->cart_dma_len = length;
+        hooks->cart_dma_dram = dram_addr;
+    }
 
     if (length != 1024 && length != 2048){
         // printf("DMA WR %08X %d bytes into %08X \n", cart_addr, length, dram_addr);
@@ -132,8 +133,8 @@ unsigned int cart_rom_dma_write(void* opaque, uint8_t* dram, uint32_t dram_addr,
         // printf("DMA WR %08X %d bytes into %08X \n", cart_addr, length, dram_addr);
         if(length>1000 && cart_addr > 0x101000) {
             // An interesting DMA triggered
-            addr_log_min = dram_addr;
-            addr_log_max = dram_addr + length;
+            hooks->dump_log_min = dram_addr;
+            hooks->dump_log_max = dram_addr + length;
         }
     }
 
@@ -120,6 +120,7 @@ void init_device(struct device* dev,
     unsigned int count_per_op,
     int no_compiled_jump,
     int randomize_interrupt,
+    int skip_polling_loops,
     uint32_t start_address,
     /* ai */
     void* aout, const struct audio_out_backend_interface* iaout,
@@ -150,6 +151,10 @@ void init_device(struct device* dev,
  */
 void poweron_device(struct device* dev);
 
+/* Release the resources allocated by a powered on device.
+ */
+void release_device(struct device* dev);
+
 /* Let device run.
  * To return from this function, a call to stop_device has to be made.
  */
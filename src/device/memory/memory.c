@@ -27,6 +27,7 @@
 #include "device/device.h"
 #include "device/rcp/rsp/rsp_core.h"
 #include "device/pif/pif.h"
+#include "osal/memory.h"
 
 #ifdef DBG
 #include <string.h>
@@ -240,14 +241,11 @@ enum {
 void* init_mem_base(void)
 {
     void* mem_base;
+    size_t page_size = 0;
 
-    /* First try the full mem base alloc */
-#ifdef _WIN32
-    mem_base = _aligned_malloc(MB_MAX_SIZE_FULL, MB_RDRAM_DRAM_ALIGNMENT_REQUIREMENT);
-#else
-    if (posix_memalign(&mem_base, MB_RDRAM_DRAM_ALIGNMENT_REQUIREMENT, MB_MAX_SIZE_FULL) != 0)
-        mem_base = NULL;
-#endif
+    /* First try the full mem base alloc, on large pages when possible
+     * (osal_alloc_pages aligns it on MB_RDRAM_DRAM_ALIGNMENT_REQUIREMENT) */
+    mem_base = osal_alloc_pages(MB_MAX_SIZE_FULL, &page_size);
     if (mem_base == NULL) {
         /* if it failed, try the compressed mem base alloc */
         mem_base = malloc(MB_MAX_SIZE);
@@ -261,7 +259,7 @@ void* init_mem_base(void)
     else {
         /* Full mem base mode has LSB = 0 */
         assert(MEM_BASE_MODE(mem_base) == 0);
-        DebugMessage(M64MSG_INFO, "Using full mem base");
+        DebugMessage(M64MSG_INFO, "Using full mem base (%u KB pages)", (unsigned int)(page_size / 1024));
     }
 
     return mem_base;
@@ -269,11 +267,9 @@ void* init_mem_base(void)
 
 void release_mem_base(void* mem_base)
 {
-#ifdef _WIN32
     if (MEM_BASE_MODE(mem_base) == 0)
-        _aligned_free(MEM_BASE_PTR(mem_base));
+        osal_free_pages(MEM_BASE_PTR(mem_base), MB_MAX_SIZE_FULL);
     else
-#endif
         free(MEM_BASE_PTR(mem_base));
 }
 
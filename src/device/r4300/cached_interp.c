@@ -34,7 +34,9 @@
 #include "api/m64p_types.h"
 #include "device/r4300/r4300_core.h"
 #include "device/r4300/idec.h"
+#include "device/r4300/polling_loop.h"
 #include "main/main.h"
+#include "main/perf_map.h"
 #include "osal/preproc.h"
 
 #ifdef DBG
@@ -136,8 +138,9 @@ void cached_interp_##name##_IDLE(void) \
     uint32_t* cp0_regs = r4300_cp0_regs(&r4300->cp0); \
     int* cp0_cycle_count = r4300_cp0_cycle_count(&r4300->cp0); \
     const int take_jump = (condition); \
+    const uint32_t jump_target = (destination); \
     if (cop1 && check_cop1_unusable(r4300)) return; \
-    if (take_jump) \
+    if (take_jump && polling_loop_can_skip(r4300, *r4300_pc(r4300), jump_target)) \
     { \
         cp0_update_count(r4300); \
         if(*cp0_cycle_count < 0) \
@@ -344,7 +347,7 @@ static void (*const ci_table[R4300_OPCODES_COUNT])(void) =
 #undef X
 
 /* return 0:normal, 1:idle, 2:out */
-static int infer_jump_sub_type(uint32_t target, uint32_t pc, uint32_t next_iw, const struct precomp_block* block)
+static int infer_jump_sub_type(struct r4300_core* r4300, uint32_t target, uint32_t pc, uint32_t next_iw, const struct precomp_block* block)
 {
     /* test if jumping to same location with empty delay slot */
     if (target == pc) {
@@ -357,6 +360,11 @@ static int infer_jump_sub_type(uint32_t target, uint32_t pc, uint32_t next_iw, c
         if (target < block->start || target >= block->end || (pc == (block->end - 4))) {
             return 2;
         }
+
+        /* test if jumping back to the start of a polling loop */
+        if (polling_loop_detect(r4300, pc, target)) {
+            return 1;
+        }
     }
 
     /* regular jump */
@@ -396,7 +404,7 @@ enum r4300_opcode r4300_decode(struct precomp_instr* inst, struct r4300_core* r4
     case R4300_OP_JAL:
         inst->f.j.inst_index  = (iw & UINT32_C(0x3ffffff));
         /* select normal, idle or out jump type */
-        opcode += infer_jump_sub_type((inst->addr & ~0xfffffff) | (idec_imm(iw, idec) & 0xfffffff), inst->addr, next_iw, block);
+        opcode += infer_jump_sub_type(r4300, (inst->addr & ~0xfffffff) | (idec_imm(iw, idec) & 0xfffffff), inst->addr, next_iw, block);
         break;
 
     case R4300_OP_BC0F:
@@ -432,7 +440,7 @@ enum r4300_opcode r4300_decode(struct precomp_instr* inst, struct r4300_core* r4
         inst->f.i.immediate  = (int16_t)iw;
 
         /* select normal, idle or out branch type */
-        opcode += infer_jump_sub_type(inst->addr + inst->f.i.immediate*4 + 4, inst->addr, next_iw, block);
+        opcode += infer_jump_sub_type(r4300, inst->addr + inst->f.i.immediate*4 + 4, inst->addr, next_iw, block);
         break;
 
     case R4300_OP_ADD:
@@ -754,8 +762,11 @@ void cached_interp_init_block(struct r4300_core* r4300, uint32_t address)
 
     /* allocate block */
     if (*block == NULL) {
-        *block = malloc(sizeof(struct precomp_block));
-        (*block)->block = NULL;
+        *block = cached_interp_alloc(&r4300->cached_interp, sizeof(struct precomp_block));
+        if (*block == NULL) {
+            DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate memory for cached interpreter.");
+            return;
+        }
         (*block)->start = address & ~UINT32_C(0xfff);
         (*block)->end = (address & ~UINT32_C(0xfff)) + 0x1000;
     }
@@ -771,14 +782,11 @@ void cached_interp_init_block(struct r4300_core* r4300, uint32_t address)
     /* allocate block instructions */
     if (!b->block)
     {
-        size_t memsize = get_block_memsize(b);
-        b->block = (struct precomp_instr*)malloc(memsize);
+        b->block = (struct precomp_instr*)cached_interp_alloc(&r4300->cached_interp, get_block_memsize(b));
         if (!b->block) {
             DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate memory for cached interpreter.");
             return;
         }
-
-        memset(b->block, 0, memsize);
     }
 
     /* reset block instructions (addr + ops) */
@@ -788,6 +796,9 @@ void cached_interp_init_block(struct r4300_core* r4300, uint32_t address)
         b->block[i].ops = cached_interp_NOTCOMPILED;
     }
 
+    /* no compiled instruction left in the page */
+    clear_code_page(&r4300->cached_interp, b->start);
+
     /* here we're marking the block as a valid code even if it's not compiled
      * yet as the game should have already set up the code correctly.
      */
@@ -819,10 +830,8 @@ void cached_interp_init_block(struct r4300_core* r4300, uint32_t address)
 
 void cached_interp_free_block(struct precomp_block* block)
 {
-    if (block->block) {
-        free(block->block);
-        block->block = NULL;
-    }
+    /* block instructions are released with the arena */
+    block->block = NULL;
 }
 
 void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw, struct precomp_block* block, uint32_t func)
@@ -841,6 +850,7 @@ void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw,
     /* reset xxhash */
     block->xxhash = 0;
 
+    set_code_page(&r4300->cached_interp, block->start);
 
     for (i = (func & 0xFFF) / 4, finished = 0; finished != 2; ++i)
     {
@@ -854,6 +864,7 @@ void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw,
             uint32_t address2 = virtual_to_physical_address(r4300, inst->addr, 0);
             if (r4300->cached_interp.blocks[address2>>12]->block[(address2&UINT32_C(0xFFF))/4].ops == cached_interp_NOTCOMPILED) {
                 r4300->cached_interp.blocks[address2>>12]->block[(address2&UINT32_C(0xFFF))/4].ops = cached_interp_NOTCOMPILED2;
+                set_code_page(&r4300->cached_interp, address2);
             }
         }
 
@@ -918,32 +929,147 @@ void cached_interpreter_jump_to(struct r4300_core* r4300, uint32_t address)
 }
 
 
+/* Blocks and the instructions of the cached interpreter are carved out
+ * of large chunks instead of being allocated one by one. They are never
+ * released individually: an invalidated block is reset in place by
+ * init_block, so the arena only grows with the amount of code touched by
+ * the game and is released as a whole by free_blocks. */
+enum { BLOCK_ARENA_CHUNK_SIZE = 4 * 1024 * 1024 };
+
+struct block_arena_chunk
+{
+    struct block_arena_chunk* next;
+    size_t size;
+    size_t used;
+};
+
+/* keep allocations aligned for any block member */
+#define BLOCK_ARENA_ALIGN(x) (((x) + 15) & ~(size_t)15)
+
+void* cached_interp_alloc(struct cached_interp* cinterp, size_t size)
+{
+    const size_t header_size = BLOCK_ARENA_ALIGN(sizeof(struct block_arena_chunk));
+    struct block_arena_chunk* chunk = cinterp->arena;
+    void* mem;
+
+    size = BLOCK_ARENA_ALIGN(size);
+
+    if (chunk == NULL || chunk->size - chunk->used < size)
+    {
+        size_t chunk_size = (size > BLOCK_ARENA_CHUNK_SIZE - header_size)
+            ? header_size + size
+            : BLOCK_ARENA_CHUNK_SIZE;
+
+        /* zero-filled, and untouched pages of the chunk cost nothing */
+        chunk = calloc(1, chunk_size);
+        if (chunk == NULL) {
+            return NULL;
+        }
+
+        chunk->next = cinterp->arena;
+        chunk->size = chunk_size;
+        chunk->used = header_size;
+        cinterp->arena = chunk;
+    }
+
+    mem = (unsigned char*)chunk + chunk->used;
+    chunk->used += size;
+
+    return mem;
+}
+
+static void free_arena(struct cached_interp* cinterp)
+{
+    struct block_arena_chunk* chunk = cinterp->arena;
+
+    while (chunk != NULL)
+    {
+        struct block_arena_chunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    cinterp->arena = NULL;
+}
+
 void init_blocks(struct cached_interp* cinterp)
 {
-    size_t i;
-    for (i = 0; i < 0x100000; ++i)
+    memset(cinterp->invalid_code, 1, sizeof(cinterp->invalid_code));
+
+    /* block pointers are NULL until their page gets executed */
+    cinterp->blocks = calloc(0x100000, sizeof(*cinterp->blocks));
+    if (cinterp->blocks == NULL) {
+        DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate block table.");
+    }
+    cinterp->arena = NULL;
+
+    memset(cinterp->code_pages, 0, sizeof(cinterp->code_pages));
+    memset(cinterp->invalidations, 0, sizeof(cinterp->invalidations));
+}
+
+/* Lists the RDRAM pages whose code was invalidated the most,
+ * to find self-modifying code or overlays loaded over and over */
+static void log_invalidations(const struct cached_interp* cinterp)
+{
+    enum { HOTSPOTS_COUNT = 8 };
+    size_t hotspots[HOTSPOTS_COUNT];
+    size_t i, j, n = 0;
+
+    for (i = 0; i < 0x800; ++i)
     {
-        cinterp->invalid_code[i] = 1;
-        cinterp->blocks[i] = NULL;
+        if (cinterp->invalidations[i] == 0) {
+            continue;
+        }
+
+        /* insertion into the hotspots, sorted by decreasing count */
+        if (n < HOTSPOTS_COUNT) {
+            j = n++;
+        }
+        else if (cinterp->invalidations[hotspots[HOTSPOTS_COUNT-1]] >= cinterp->invalidations[i]) {
+            continue;
+        }
+        else {
+            j = HOTSPOTS_COUNT-1;
+        }
+
+        for (; j > 0 && cinterp->invalidations[hotspots[j-1]] < cinterp->invalidations[i]; --j) {
+            hotspots[j] = hotspots[j-1];
+        }
+        hotspots[j] = i;
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        DebugMessage(M64MSG_VERBOSE, "code invalidations of RDRAM page %08" PRIX32 ": %" PRIu32,
+                     (uint32_t)(hotspots[i] << 12), cinterp->invalidations[hotspots[i]]);
     }
 }
 
 void free_blocks(struct cached_interp* cinterp)
 {
     size_t i;
-    for (i = 0; i < 0x100000; ++i)
+
+    log_invalidations(cinterp);
+
+    if (cinterp->blocks != NULL)
     {
-        if (cinterp->blocks[i])
+        for (i = 0; i < 0x100000; ++i)
         {
-            cinterp->free_block(cinterp->blocks[i]);
-            free(cinterp->blocks[i]);
-            cinterp->blocks[i] = NULL;
+            if (cinterp->blocks[i]) {
+                cinterp->free_block(cinterp->blocks[i]);
+            }
         }
+
+        free(cinterp->blocks);
+        cinterp->blocks = NULL;
     }
+
+    free_arena(cinterp);
 }
 
 void invalidate_cached_code_hacktarux(struct r4300_core* r4300, uint32_t address, size_t size)
 {
+    struct cached_interp* const cinterp = &r4300->cached_interp;
     size_t i;
     uint32_t addr;
     uint32_t addr_max;
@@ -951,7 +1077,7 @@ void invalidate_cached_code_hacktarux(struct r4300_core* r4300, uint32_t address
     if (size == 0)
     {
         /* invalidate everthing */
-        memset(r4300->cached_interp.invalid_code, 1, 0x100000);
+        memset(cinterp->invalid_code, 1, 0x100000);
     }
     else
     {
@@ -962,12 +1088,22 @@ void invalidate_cached_code_hacktarux(struct r4300_core* r4300, uint32_t address
         {
             i = (addr >> 12);
 
-            if (r4300->cached_interp.invalid_code[i] == 0)
+            if (!(cinterp->code_pages[i >> 5] & (UINT32_C(1) << (i & 31))))
+            {
+                /* no compiled code in this page, nor in the next ones of the
+                 * same bitmap word if it is all clear: go directly to the
+                 * next page (or to the next 32 pages) */
+                addr |= (cinterp->code_pages[i >> 5] == 0) ? 0x1fffc : 0xffc;
+            }
+            else if (cinterp->invalid_code[i] == 0)
             {
-                if (r4300->cached_interp.blocks[i] == NULL
-                 || r4300->cached_interp.blocks[i]->block[(addr & 0xfff) / 4].ops != r4300->cached_interp.not_compiled)
+                if (cinterp->blocks[i] == NULL
+                 || cinterp->blocks[i]->block[(addr & 0xfff) / 4].ops != cinterp->not_compiled)
                 {
-                    r4300->cached_interp.invalid_code[i] = 1;
+                    cinterp->invalid_code[i] = 1;
+                    if ((addr & UINT32_C(0xc0000000)) == UINT32_C(0x80000000)) {
+                        ++cinterp->invalidations[(addr >> 12) & 0x7ff];
+                    }
                     /* go directly to next i */
                     addr &= ~0xfff;
                     addr |= 0xffc;
@@ -26,6 +26,9 @@
 #include <stdint.h>
 
 #include "idec.h"
+#include "r4300_core.h"
+
+#include "osal/preproc.h"
 
 struct r4300_core;
 struct cached_interp;
@@ -43,9 +46,24 @@ void cached_interp_free_block(struct precomp_block* block);
 
 void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw, struct precomp_block* block, uint32_t func);
 
+/* Code page bits are set when an instruction of the page is compiled,
+ * and cleared when the block of the page is reset to not compiled. */
+static osal_inline void set_code_page(struct cached_interp* cinterp, uint32_t address)
+{
+    cinterp->code_pages[address >> 17] |= UINT32_C(1) << ((address >> 12) & 31);
+}
+
+static osal_inline void clear_code_page(struct cached_interp* cinterp, uint32_t address)
+{
+    cinterp->code_pages[address >> 17] &= ~(UINT32_C(1) << ((address >> 12) & 31));
+}
+
 void init_blocks(struct cached_interp* cinterp);
 void free_blocks(struct cached_interp* cinterp);
 
+/* Allocates zero-filled memory for blocks, which lives until free_blocks */
+void* cached_interp_alloc(struct cached_interp* cinterp, size_t size);
+
 void invalidate_cached_code_hacktarux(struct r4300_core* r4300, uint32_t address, size_t size);
 
 void run_cached_interpreter(struct r4300_core* r4300);
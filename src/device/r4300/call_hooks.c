@@ -0,0 +1,250 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - call_hooks.c                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "call_hooks.h"
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "device/r4300/r4300_core.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const gpr_names[32] =
+{
+    "zero", "at", "v0", "v1", "a0", "a1", "a2", "a3",
+    "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7",
+    "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7",
+    "t8", "t9", "k0", "k1", "gp", "sp", "fp", "ra"
+};
+
+static void call_hooks_update_filter(struct call_hooks* table)
+{
+    size_t i;
+
+    memset(table->filter, 0, sizeof(table->filter));
+    for (i = 0; i < table->count; ++i)
+    {
+        uint32_t bit = (table->hooks[i].target >> 2) & (CALL_HOOKS_FILTER_BITS - 1);
+        table->filter[bit >> 5] |= UINT32_C(1) << (bit & 31);
+    }
+}
+
+/* index of the first hook whose target is >= target */
+static size_t call_hooks_lower_bound(const struct call_hooks* table, uint32_t target)
+{
+    size_t lo = 0, hi = table->count;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (table->hooks[mid].target < target)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+int call_hooks_add(struct call_hooks* table, const struct call_hook* hook)
+{
+    struct call_hook* hooks;
+    size_t pos;
+
+    /* keep insertion order among hooks of the same target,
+     * the search has to run before realloc moves the table */
+    pos = call_hooks_lower_bound(table, hook->target + 1);
+    if (hook->target == UINT32_MAX)
+        pos = table->count;
+
+    hooks = realloc(table->hooks, (table->count + 1) * sizeof(*hooks));
+    if (hooks == NULL)
+        return 0;
+
+    memmove(&hooks[pos + 1], &hooks[pos], (table->count - pos) * sizeof(*hooks));
+    hooks[pos] = *hook;
+
+    table->hooks = hooks;
+    ++table->count;
+    call_hooks_update_filter(table);
+
+    return 1;
+}
+
+void call_hooks_remove(struct call_hooks* table, uint32_t target)
+{
+    size_t first = call_hooks_lower_bound(table, target);
+    size_t last = first;
+
+    while (last < table->count && table->hooks[last].target == target)
+        ++last;
+
+    memmove(&table->hooks[first], &table->hooks[last], (table->count - last) * sizeof(*table->hooks));
+    table->count -= last - first;
+    call_hooks_update_filter(table);
+}
+
+void call_hooks_clear(struct call_hooks* table)
+{
+    free(table->hooks);
+    table->hooks = NULL;
+    table->count = 0;
+    memset(table->filter, 0, sizeof(table->filter));
+}
+
+static int parse_gpr(const char* name, size_t len)
+{
+    size_t i;
+    char* end;
+    long reg;
+
+    for (i = 0; i < 32; ++i)
+    {
+        if (strlen(gpr_names[i]) == len && strncmp(gpr_names[i], name, len) == 0)
+            return (int) i;
+    }
+
+    if (len > 1 && (name[0] == 'r' || name[0] == '$'))
+    {
+        reg = strtol(name + 1, &end, 10);
+        if (end == name + len && reg >= 0 && reg < 32)
+            return (int) reg;
+    }
+
+    return -1;
+}
+
+/* Parse a list of hooks separated by ';' or white space, each of the form
+ *   <target>:print@<addr>     print the guest string at <addr>
+ *   <target>:<reg>=<value>    set register <reg> (e.g. a0 or r4) to <value>
+ * where <target> and <addr> are hexadecimal and <value> is a C integer. */
+int call_hooks_parse(struct call_hooks* table, const char* spec)
+{
+    const char* p = spec;
+    int errors = 0;
+
+    while (*p != '\0')
+    {
+        struct call_hook hook;
+        const char* entry;
+        const char* action;
+        const char* eq;
+        size_t len;
+        char* end;
+        int reg;
+
+        while (*p == ';' || isspace((unsigned char) *p))
+            ++p;
+        if (*p == '\0')
+            break;
+
+        entry = p;
+        len = strcspn(entry, "; \t\r\n");
+        p += len;
+
+        memset(&hook, 0, sizeof(hook));
+        hook.target = (uint32_t) strtoul(entry, &end, 16);
+        if (end == entry || *end != ':')
+            goto invalid;
+        action = end + 1;
+
+        if (strncmp(action, "print@", 6) == 0)
+        {
+            hook.action = CALL_HOOK_PRINT_STRING;
+            hook.addr = (uint32_t) strtoul(action + 6, &end, 16);
+            if (end == action + 6 || end != entry + len)
+                goto invalid;
+        }
+        else if ((eq = memchr(action, '=', entry + len - action)) != NULL
+              && (reg = parse_gpr(action, eq - action)) > 0)
+        {
+            hook.action = CALL_HOOK_SET_REG;
+            hook.reg = (uint32_t) reg;
+            hook.value = strtoll(eq + 1, &end, 0);
+            if (end == eq + 1 || end != entry + len)
+                goto invalid;
+        }
+        else
+            goto invalid;
+
+        if (!call_hooks_add(table, &hook))
+            return 0;
+        continue;
+
+    invalid:
+        DebugMessage(M64MSG_WARNING, "Invalid call hook '%.*s'", (int) len, entry);
+        ++errors;
+    }
+
+    return errors == 0;
+}
+
+static void print_guest_string(struct r4300_core* r4300, uint32_t address)
+{
+    char buffer[1025];
+    size_t i, n = 0;
+    uint32_t word;
+
+    address &= ~UINT32_C(3);
+    while (n < sizeof(buffer) - 1)
+    {
+        if (!_untracked_r4300_read_aligned_word(r4300, address, &word, "call hook"))
+            break;
+        address += 4;
+
+        for (i = 0; i < 4 && n < sizeof(buffer) - 1; ++i)
+        {
+            char c = (char) (word >> (24 - 8 * i));
+            if (c == '\0')
+                goto done;
+            buffer[n++] = c;
+        }
+    }
+
+done:
+    buffer[n] = '\0';
+    printf("printf |%s\n", buffer);
+    fflush(stdout);
+}
+
+void run_call_hooks(struct r4300_core* r4300, uint32_t target)
+{
+    const struct call_hooks* table = &r4300->hooks.call_hooks;
+    size_t i;
+
+    for (i = call_hooks_lower_bound(table, target); i < table->count && table->hooks[i].target == target; ++i)
+    {
+        const struct call_hook* hook = &table->hooks[i];
+
+        switch (hook->action)
+        {
+        case CALL_HOOK_PRINT_STRING:
+            print_guest_string(r4300, hook->addr);
+            break;
+        case CALL_HOOK_SET_REG:
+            r4300_regs(r4300)[hook->reg] = hook->value;
+            break;
+        }
+    }
+}
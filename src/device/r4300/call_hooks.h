@@ -0,0 +1,79 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - call_hooks.h                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DEVICE_R4300_CALL_HOOKS_H
+#define M64P_DEVICE_R4300_CALL_HOOKS_H
+
+#include "osal/preproc.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct r4300_core;
+
+/* Call-target hooks are native actions run by the interpreter when a linking
+ * jump (JAL, JALR, BxxAL) lands on a given target, e.g. to print a guest
+ * string buffer when its flush function is called, or to override the
+ * arguments of a function. They are configured with the CallHooks core
+ * parameter or from python hooks. */
+
+enum call_hook_action
+{
+    CALL_HOOK_PRINT_STRING, /* print the NUL-terminated guest string at addr */
+    CALL_HOOK_SET_REG       /* set GPR reg to value */
+};
+
+struct call_hook
+{
+    uint32_t target;
+    enum call_hook_action action;
+    uint32_t addr;
+    uint32_t reg;
+    int64_t value;
+};
+
+#define CALL_HOOKS_FILTER_BITS 1024
+
+struct call_hooks
+{
+    /* sorted by target */
+    struct call_hook* hooks;
+    size_t count;
+
+    /* one bit per (target >> 2) modulo CALL_HOOKS_FILTER_BITS,
+     * so that jumps to targets without hooks are rejected with one test */
+    uint32_t filter[CALL_HOOKS_FILTER_BITS / 32];
+};
+
+int call_hooks_add(struct call_hooks* table, const struct call_hook* hook);
+void call_hooks_remove(struct call_hooks* table, uint32_t target);
+void call_hooks_clear(struct call_hooks* table);
+int call_hooks_parse(struct call_hooks* table, const char* spec);
+
+void run_call_hooks(struct r4300_core* r4300, uint32_t target);
+
+static osal_inline int call_hooks_match(const struct call_hooks* table, uint32_t target)
+{
+    uint32_t bit = (target >> 2) & (CALL_HOOKS_FILTER_BITS - 1);
+    return (table->filter[bit >> 5] >> (bit & 31)) & 1;
+}
+
+#endif
@@ -133,31 +133,18 @@ enum r4300_cp0_registers
 
 
 
-enum { INTERRUPT_NODES_POOL_CAPACITY = 16 };
-
-struct interrupt_event
-{
-    int type;
-    unsigned int count;
-};
-
-struct node
-{
-    struct interrupt_event data;
-    struct node *next;
-};
-
-struct pool
-{
-    struct node nodes [INTERRUPT_NODES_POOL_CAPACITY];
-    struct node* stack[INTERRUPT_NODES_POOL_CAPACITY];
-    size_t index;
-};
+/* one slot per event type (VI_INT ... RSP_DMA_EVT) */
+enum { INTERRUPT_EVENT_TYPES_COUNT = 12 };
 
 struct interrupt_queue
 {
-    struct pool pool;
-    struct node* first;
+    /* count of each pending event, indexed by the bit number of its type */
+    unsigned int counts[INTERRUPT_EVENT_TYPES_COUNT];
+    /* bit numbers of the pending events, in the order they will be generated */
+    uint8_t order[INTERRUPT_EVENT_TYPES_COUNT];
+    size_t size;
+    /* mask of the pending event types */
+    unsigned int pending;
 };
 
 struct interrupt_handler
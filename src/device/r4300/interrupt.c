@@ -45,57 +45,68 @@
 #include "device/rcp/vi/vi_controller.h"
 #include "main/main.h"
 #include "main/savestates.h"
+#include "osal/preproc.h"
 
 
 /***************************************************************************
- * Pool of Single Linked List Nodes
+ * Interrupt Queue
  **************************************************************************/
 
-static struct node* alloc_node(struct pool* p);
-static void free_node(struct pool* p, struct node* node);
-static void clear_pool(struct pool* p);
-
+/* Pending events are kept in one slot per event type, so that looking up an
+ * event is a single array access, and their order of generation is kept in
+ * a small array of slot numbers, so that the next event is always order[0]. */
 
-/* node allocation/deallocation on a given pool */
-static struct node* alloc_node(struct pool* p)
+static int event_slot(int type)
 {
-    /* return NULL if pool is too small */
-    if (p->index >= INTERRUPT_NODES_POOL_CAPACITY) {
-        return NULL;
+    /* event types are single bits */
+    if (type <= 0 || type >= (1 << INTERRUPT_EVENT_TYPES_COUNT) || (type & (type - 1)) != 0) {
+        return -1;
     }
 
-    return p->stack[p->index++];
+#if defined(__GNUC__)
+    return __builtin_ctz(type);
+#else
+    {
+        int slot = 0;
+        while (!(type & 1)) {
+            type >>= 1;
+            ++slot;
+        }
+        return slot;
+    }
+#endif
 }
 
-static void free_node(struct pool* p, struct node* node)
+static void clear_queue(struct interrupt_queue* q)
 {
-    if (p->index == 0 || node == NULL) {
-        return;
-    }
-
-    p->stack[--p->index] = node;
+    q->size = 0;
+    q->pending = 0;
 }
 
-/* release all nodes */
-static void clear_pool(struct pool* p)
+static osal_inline int first_event_type(const struct interrupt_queue* q)
 {
-    size_t i;
-
-    for (i = 0; i < INTERRUPT_NODES_POOL_CAPACITY; ++i) {
-        p->stack[i] = &p->nodes[i];
-    }
+    return 1 << q->order[0];
+}
 
-    p->index = 0;
+static osal_inline unsigned int first_event_count(const struct interrupt_queue* q)
+{
+    return q->counts[q->order[0]];
 }
 
-/***************************************************************************
- * Interrupt Queue
- **************************************************************************/
+static void insert_event_at(struct interrupt_queue* q, size_t pos, int slot, unsigned int count)
+{
+    memmove(&q->order[pos + 1], &q->order[pos], q->size - pos);
+    q->order[pos] = (uint8_t)slot;
+    q->counts[slot] = count;
+    q->pending |= 1u << slot;
+    ++q->size;
+}
 
-static void clear_queue(struct interrupt_queue* q)
+static void remove_event_at(struct interrupt_queue* q, size_t pos)
 {
-    q->first = NULL;
-    clear_pool(&q->pool);
+    q->pending &= ~(1u << q->order[pos]);
+    --q->size;
+    memmove(&q->order[pos], &q->order[pos + 1], q->size - pos);
 }
 
 static int before_event(const struct cp0* cp0, unsigned int evt1, unsigned int evt2, int type2)
@@ -134,147 +145,123 @@ void add_interrupt_event(struct cp0* cp0, int type, unsigned int delay)
 
 void add_interrupt_event_count(struct cp0* cp0, int type, unsigned int count)
 {
-    struct node* event;
-    struct node* e;
+    struct interrupt_queue* q = &cp0->q;
+    size_t pos;
+    int slot = event_slot(type);
     const uint32_t* cp0_regs = r4300_cp0_regs(cp0);
     unsigned int* cp0_next_interrupt = r4300_cp0_next_interrupt(cp0);
     int* cp0_cycle_count = r4300_cp0_cycle_count(cp0);
 
-    if (get_event(&cp0->q, type)) {
-        DebugMessage(M64MSG_WARNING, "two events of type 0x%x in interrupt queue", type);
-    }
-
-    event = alloc_node(&cp0->q.pool);
-    if (event == NULL)
+    if (slot < 0)
     {
-        DebugMessage(M64MSG_ERROR, "Failed to allocate node for new interrupt event");
+        DebugMessage(M64MSG_ERROR, "Invalid interrupt event type 0x%x", type);
         return;
     }
 
-    event->data.count = count;
-    event->data.type = type;
-
-    if (cp0->q.first == NULL)
-    {
-        cp0->q.first = event;
-        event->next = NULL;
-        *cp0_next_interrupt = cp0->q.first->data.count;
-        *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - cp0->q.first->data.count;
+    if (q->pending & type) {
+        DebugMessage(M64MSG_WARNING, "two events of type 0x%x in interrupt queue", type);
+        cancel_interrupt_event(cp0, type);
     }
-    else if (before_event(cp0, count, cp0->q.first->data.count, cp0->q.first->data.type))
+
+    if (q->size == 0 || before_event(cp0, count, first_event_count(q), first_event_type(q)))
     {
-        event->next = cp0->q.first;
-        cp0->q.first = event;
-        *cp0_next_interrupt = cp0->q.first->data.count;
-        *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - cp0->q.first->data.count;
+        insert_event_at(q, 0, slot, count);
+        *cp0_next_interrupt = count;
+        *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - count;
     }
     else
     {
-        for (e = cp0->q.first;
-            e->next != NULL &&
-            (!before_event(cp0, count, e->next->data.count, e->next->data.type));
-            e = e->next);
+        /* after every event not strictly after it, so that events with
+         * the same count are generated in the order they were added */
+        for (pos = 1;
+            pos < q->size &&
+            (!before_event(cp0, count, q->counts[q->order[pos]], 1 << q->order[pos]));
+            ++pos);
 
-        if (e->next == NULL)
-        {
-            e->next = event;
-            event->next = NULL;
-        }
-        else
-        {
-            for(; e->next != NULL && e->next->data.count == count; e = e->next);
+        for (; pos < q->size && q->counts[q->order[pos]] == count; ++pos);
 
-            event->next = e->next;
-            e->next = event;
-        }
+        insert_event_at(q, pos, slot, count);
     }
 }
 
 void remove_interrupt_event(struct cp0* cp0)
 {
-    struct node* e;
+    struct interrupt_queue* q = &cp0->q;
     const uint32_t* cp0_regs = r4300_cp0_regs(cp0);
     unsigned int* cp0_next_interrupt = r4300_cp0_next_interrupt(cp0);
     int* cp0_cycle_count = r4300_cp0_cycle_count(cp0);
 
-    e = cp0->q.first;
-    cp0->q.first = e->next;
-    free_node(&cp0->q.pool, e);
+    remove_event_at(q, 0);
 
-    *cp0_next_interrupt = (cp0->q.first != NULL)
-        ? cp0->q.first->data.count
+    *cp0_next_interrupt = (q->size != 0)
+        ? first_event_count(q)
         : 0;
 
-    *cp0_cycle_count = (cp0->q.first != NULL)
-        ? (cp0_regs[CP0_COUNT_REG] - cp0->q.first->data.count)
+    *cp0_cycle_count = (q->size != 0)
+        ? (cp0_regs[CP0_COUNT_REG] - first_event_count(q))
         : 0;
 }
 
-unsigned int* get_event(const struct interrupt_queue* q, int type)
+/* Removes the pending event of the given type, if any.
+ * Unlike remove_event, keeps the next interrupt up to date. */
+void cancel_interrupt_event(struct cp0* cp0, int type)
 {
-    struct node* e = q->first;
-
-    if (e == NULL) {
-        return NULL;
-    }
-
-    if (e->data.type == type) {
-        return &e->data.count;
-    }
+    if (get_next_event_type(&cp0->q) == type)
+        remove_interrupt_event(cp0);
+    else
+        remove_event(&cp0->q, type);
+}
 
-    for (; e->next != NULL && e->next->data.type != type; e = e->next);
+unsigned int* get_event(const struct interrupt_queue* q, int type)
+{
+    int slot = event_slot(type);
 
-    return (e->next != NULL)
-        ? &e->next->data.count
+    return (slot >= 0 && (q->pending & type))
+        ? (unsigned int*)&q->counts[slot] /* OK to cast away const qualifier */
         : NULL;
 }
 
 int get_next_event_type(const struct interrupt_queue* q)
 {
-    return (q->first == NULL)
+    return (q->size == 0)
+        ? 0
+        : first_event_type(q);
+}
+
+unsigned int get_next_event_count(const struct interrupt_queue* q)
+{
+    return (q->size == 0)
         ? 0
-        : q->first->data.type;
+        : first_event_count(q);
 }
 
 void remove_event(struct interrupt_queue* q, int type)
 {
-    struct node* to_del;
-    struct node* e = q->first;
+    size_t pos;
+    int slot = event_slot(type);
 
-    if (e == NULL) {
+    if (slot < 0 || !(q->pending & type)) {
         return;
     }
 
-    if (e->data.type == type)
-    {
-        q->first = e->next;
-        free_node(&q->pool, e);
-    }
-    else
-    {
-        for (; e->next != NULL && e->next->data.type != type; e = e->next);
+    for (pos = 0; q->order[pos] != slot; ++pos);
 
-        if (e->next != NULL)
-        {
-            to_del = e->next;
-            e->next = to_del->next;
-            free_node(&q->pool, to_del);
-        }
-    }
+    remove_event_at(q, pos);
 }
 
 void translate_event_queue(struct cp0* cp0, unsigned int base)
 {
-    struct node* e;
+    size_t i;
     uint32_t* cp0_regs = r4300_cp0_regs(cp0);
     int* cp0_cycle_count = r4300_cp0_cycle_count(cp0);
 
     remove_event(&cp0->q, COMPARE_INT);
     remove_event(&cp0->q, SPECIAL_INT);
 
-    for (e = cp0->q.first; e != NULL; e = e->next)
+    for (i = 0; i < cp0->q.size; ++i)
     {
-        e->data.count = (e->data.count - cp0_regs[CP0_COUNT_REG]) + base;
+        unsigned int* count = &cp0->q.counts[cp0->q.order[i]];
+        *count = (*count - cp0_regs[CP0_COUNT_REG]) + base;
     }
 
     cp0_regs[CP0_COUNT_REG] = base;
@@ -287,20 +274,21 @@ void translate_event_queue(struct cp0* cp0, unsigned int base)
     cp0_regs[CP0_COUNT_REG] -= cp0->count_per_op;
 
     /* Update next interrupt in case first event is COMPARE_INT */
-    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - cp0->q.first->data.count;
+    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - first_event_count(&cp0->q);
 }
 
 int save_eventqueue_infos(const struct cp0* cp0, char *buf)
 {
     int len;
-    struct node* e;
+    size_t i;
 
     len = 0;
 
-    for (e = cp0->q.first; e != NULL; e = e->next)
+    for (i = 0; i < cp0->q.size; ++i)
     {
-        memcpy(buf + len    , &e->data.type , 4);
-        memcpy(buf + len + 4, &e->data.count, 4);
+        int type = 1 << cp0->q.order[i];
+        memcpy(buf + len    , &type, 4);
+        memcpy(buf + len + 4, &cp0->q.counts[cp0->q.order[i]], 4);
         len += 8;
     }
 
@@ -336,7 +324,6 @@ void init_interrupt(struct cp0* cp0)
 
 void r4300_check_interrupt(struct r4300_core* r4300, uint32_t cause_ip, int set_cause)
 {
-    struct node* event;
     uint32_t* cp0_regs = r4300_cp0_regs(&r4300->cp0);
     unsigned int* cp0_next_interrupt = r4300_cp0_next_interrupt(&r4300->cp0);
     int* cp0_cycle_count = r4300_cp0_cycle_count(&r4300->cp0);
@@ -353,29 +340,12 @@ void r4300_check_interrupt(struct r4300_core* r4300, uint32_t cause_ip, int set_
     }
     if (cp0_regs[CP0_STATUS_REG] & cp0_regs[CP0_CAUSE_REG] & UINT32_C(0xFF00))
     {
-        event = alloc_node(&r4300->cp0.q.pool);
-
-        if (event == NULL)
-        {
-            DebugMessage(M64MSG_ERROR, "Failed to allocate node for new interrupt event");
-            return;
-        }
+        /* CHECK_INT is generated right away, ahead of every other event */
+        remove_event(&r4300->cp0.q, CHECK_INT);
+        insert_event_at(&r4300->cp0.q, 0, event_slot(CHECK_INT), cp0_regs[CP0_COUNT_REG]);
 
-        event->data.count = *cp0_next_interrupt = cp0_regs[CP0_COUNT_REG];
-        event->data.type = CHECK_INT;
+        *cp0_next_interrupt = cp0_regs[CP0_COUNT_REG];
         *cp0_cycle_count = 0;
-
-        if (r4300->cp0.q.first == NULL)
-        {
-            r4300->cp0.q.first = event;
-            event->next = NULL;
-        }
-        else
-        {
-            event->next = r4300->cp0.q.first;
-            r4300->cp0.q.first = event;
-
-        }
     }
 }
 
@@ -408,7 +378,7 @@ void compare_int_handler(void* opaque)
     cp0_regs[CP0_COUNT_REG] -= r4300->cp0.count_per_op;
 
     /* Update next interrupt in case first event is COMPARE_INT */
-    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - r4300->cp0.q.first->data.count;
+    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - first_event_count(&r4300->cp0.q);
 
     raise_maskable_interrupt(r4300, CP0_CAUSE_IP7);
 }
@@ -570,12 +540,12 @@ void gen_interrupt(struct r4300_core* r4300)
         uint32_t dest = r4300->skip_jump;
         r4300->skip_jump = 0;
 
-        *cp0_next_interrupt = (r4300->cp0.q.first != NULL)
-            ? r4300->cp0.q.first->data.count
+        *cp0_next_interrupt = (r4300->cp0.q.size != 0)
+            ? first_event_count(&r4300->cp0.q)
             : 0;
 
-        *cp0_cycle_count = (r4300->cp0.q.first != NULL)
-            ? (cp0_regs[CP0_COUNT_REG] - r4300->cp0.q.first->data.count)
+        *cp0_cycle_count = (r4300->cp0.q.size != 0)
+            ? (cp0_regs[CP0_COUNT_REG] - first_event_count(&r4300->cp0.q))
             : 0;
 
         r4300->cp0.last_addr = dest;
@@ -583,7 +553,7 @@ void gen_interrupt(struct r4300_core* r4300)
         return;
     }
 
-    switch (r4300->cp0.q.first->data.type)
+    switch (first_event_type(&r4300->cp0.q))
     {
         case VI_INT:
             call_interrupt_handler(&r4300->cp0, 0);
@@ -644,7 +614,7 @@ void gen_interrupt(struct r4300_core* r4300)
             break;
 
         default:
-            DebugMessage(M64MSG_ERROR, "Unknown interrupt queue event type %.8X.", r4300->cp0.q.first->data.type);
+            DebugMessage(M64MSG_ERROR, "Unknown interrupt queue event type %.8X.", first_event_type(&r4300->cp0.q));
             remove_interrupt_event(&r4300->cp0);
             exception_general(r4300);
             break;
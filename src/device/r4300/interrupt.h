@@ -41,8 +41,10 @@ void add_interrupt_event_count(struct cp0* cp0, int type, unsigned int count);
 void add_interrupt_event(struct cp0* cp0, int type, unsigned int delay);
 unsigned int* get_event(const struct interrupt_queue* q, int type);
 int get_next_event_type(const struct interrupt_queue* q);
+unsigned int get_next_event_count(const struct interrupt_queue* q);
 unsigned int add_random_interrupt_time(struct r4300_core* r4300);
 void remove_interrupt_event(struct cp0* cp0);
+void cancel_interrupt_event(struct cp0* cp0, int type);
 
 int save_eventqueue_infos(const struct cp0* cp0, char *buf);
 void load_eventqueue_infos(struct cp0* cp0, const char *buf);
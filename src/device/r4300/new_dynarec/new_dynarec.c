@@ -18,6 +18,7 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -33,7 +34,9 @@
 #include "api/m64p_types.h"
 #include "api/callbacks.h"
 #include "main/main.h"
+#include "main/perf_map.h"
 #include "main/rom.h"
+#include "osal/memory.h"
 #include "device/memory/memory.h"
 #include "device/r4300/cached_interp.h"
 #include "device/r4300/cp0.h"
@@ -238,6 +241,7 @@ unsigned int stop_after_jal;
 
 static u_int start;
 static u_int *source;
+static int block_tlb; // the block looks up memory_map: TLB, or RAM hooks
 static u_int pagelimit;
 static char insn[MAXBLOCK][10];
 static u_char itype[MAXBLOCK];
@@ -285,7 +289,13 @@ static int is_delayslot;
 static int cop1_usable;
 static char *copy;
 static int expirep;
+static int cache_size_2=TARGET_SIZE_2; // log2 of the part of the cache in use
+static int cache_size_2_requested=TARGET_SIZE_2;
+static struct new_dynarec_stats stats;
 static u_int dirty_entry_count;
+static int ram_hooks_running;
+static uint8_t ram_hook_pages[2048]; // hooks.ram_pages, as applied to memory_map
+static int ram_hooks_lookup; // some pages are hooked, see new_recompile_block
 static u_int copy_size;
 static struct ll_entry* hash_table[65536][2];
 static struct ll_entry *jump_in[4096];
@@ -1704,6 +1714,27 @@ static void remove_hash(u_int vaddr)
   }
 }
 
+// RAM hooks: pages with read hooks are unmapped and pages with write
+// hooks are write protected, so that only their accesses take the slow
+// path to the python hook layer.  While some pages are hooked, the blocks
+// with loads or stores are compiled with the TLB lookup code, which reads
+// memory_map (see new_recompile_block).
+static int ram_read_hooked(u_int addr)
+{
+  return (addr^0x80000000)<0x800000&&(ram_hook_pages[(addr>>12)&2047]&R4300_HOOK_RAM_READ);
+}
+
+static void ram_hooks_apply(u_int page)
+{
+  uintptr_t map;
+  if(page<0x80000||page>=0x80800) return;
+  map=((uintptr_t)g_dev.rdram.dram-(uintptr_t)0x80000000)>>2;
+  if(!g_dev.r4300.cached_interp.invalid_code[page]) map|=WRITE_PROTECT;
+  if(ram_hook_pages[page&2047]&R4300_HOOK_RAM_WRITE) map|=WRITE_PROTECT;
+  if(ram_hook_pages[page&2047]&R4300_HOOK_RAM_READ) map=(uintptr_t)-1;
+  g_dev.r4300.new_dynarec_hot_state.memory_map[page]=map;
+}
+
 #if NEW_DYNAREC == NEW_DYNAREC_X86
 #include "x86/assem_x86.c"
 #elif NEW_DYNAREC == NEW_DYNAREC_X64
@@ -1785,10 +1816,12 @@ u_int verify_dirty(struct ll_entry * head)
   else
     assert(0);
 
-  if(memcmp(source,head->copy,head->length))
+  if(memcmp(source,head->copy,head->length)) {
+    stats.dirty_misses++;
     return head->vaddr;
-  else
-    return 0;
+  }
+  stats.dirty_hits++;
+  return 0;
 }
 
 // Add virtual address mapping for 32-bit compiled block
@@ -1815,10 +1848,11 @@ static struct ll_entry *ll_add(struct ll_entry **head,int vaddr,void *addr,void
   return ll_add_32(head,vaddr,0,addr,clean_addr,start,copy,length);
 }
 
-static void ll_remove_matching_addrs(struct ll_entry **head,intptr_t addr,int shift)
+static int ll_remove_matching_addrs(struct ll_entry **head,intptr_t addr,int shift)
 {
   struct ll_entry **cur=head;
   struct ll_entry *next;
+  int removed=0;
   while(*cur) {
     if((((uintptr_t)((*cur)->addr)-(uintptr_t)base_addr)>>shift)==((addr-(uintptr_t)base_addr)>>shift) ||
        (((uintptr_t)((*cur)->addr)-(uintptr_t)base_addr-MAX_OUTPUT_BLOCK_SIZE)>>shift)==((addr-(uintptr_t)base_addr)>>shift))
@@ -1838,12 +1872,14 @@ static void ll_remove_matching_addrs(struct ll_entry **head,intptr_t addr,int sh
       next=(*cur)->next;
       free(*cur);
       *cur=next;
+      removed++;
     }
     else
     {
       cur=&((*cur)->next);
     }
   }
+  return removed;
 }
 
 // Remove all entries from linked list
@@ -1897,7 +1933,7 @@ static void ll_kill_pointers(struct ll_entry *head,intptr_t addr,int shift)
 static void add_link(u_int vaddr,void *src)
 {
   u_int page=(vaddr^0x80000000)>>12;
-  if(page>262143&&g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]) page=(g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]^0x80000000)>>12;
+  if(page>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)) page=(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)^0x80000000)>>12;
   if(page>4095) page=2048+(page&2047);
   inv_debug("add_link: %x -> %x (%d)\n",(intptr_t)src,vaddr,page);
   (void)ll_add(jump_out+page,vaddr,src,src,0,NULL,0);
@@ -1908,7 +1944,7 @@ static void add_link(u_int vaddr,void *src)
 static struct ll_entry *get_clean(struct r4300_core* r4300,u_int vaddr,u_int flags)
 {
   u_int page=(vaddr^0x80000000)>>12;
-  if(page>262143&&r4300->cp0.tlb.LUT_r[vaddr>>12]) page=(r4300->cp0.tlb.LUT_r[vaddr>>12]^0x80000000)>>12;
+  if(page>262143&&tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)) page=(tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)^0x80000000)>>12;
   if(page>2048) page=2048+(page&2047);
   struct ll_entry *head;
   head=jump_in[page];
@@ -1925,23 +1961,23 @@ static struct ll_entry *get_dirty(struct r4300_core* r4300,u_int vaddr,u_int fla
 {
   u_int page=(vaddr^0x80000000)>>12;
   u_int vpage=page;
-  if(page>262143&&r4300->cp0.tlb.LUT_r[vaddr>>12]) page=(r4300->cp0.tlb.LUT_r[vaddr>>12]^0x80000000)>>12;
+  if(page>262143&&tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)) page=(tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)^0x80000000)>>12;
   if(page>2048) page=2048+(page&2047);
-  if(vpage>262143&&r4300->cp0.tlb.LUT_r[vaddr>>12]) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
+  if(vpage>262143&&tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
   if(vpage>2048) vpage=2048+(vpage&2047);
   struct ll_entry *head;
   head=jump_dirty[vpage];
   while(head!=NULL) {
     if(head->vaddr==vaddr&&(head->reg32&flags)==0) {
       // Don't restore blocks which are about to expire from the cache
-      if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
+      if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-cache_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-cache_size_2))) {
         if(verify_dirty(head)==0) {
           r4300->cached_interp.invalid_code[vaddr>>12]=0;
           r4300->new_dynarec_hot_state.memory_map[vaddr>>12]|=WRITE_PROTECT;
           if(vpage<2048) {
-            if(r4300->cp0.tlb.LUT_r[vaddr>>12]) {
-              r4300->cached_interp.invalid_code[r4300->cp0.tlb.LUT_r[vaddr>>12]>>12]=0;
-              r4300->new_dynarec_hot_state.memory_map[r4300->cp0.tlb.LUT_r[vaddr>>12]>>12]|=WRITE_PROTECT;
+            if(tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)) {
+              r4300->cached_interp.invalid_code[tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)>>12]=0;
+              r4300->new_dynarec_hot_state.memory_map[tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)>>12]|=WRITE_PROTECT;
             }
             r4300->new_dynarec_hot_state.restore_candidate[vpage>>3]|=1<<(vpage&7);
           }
@@ -1955,6 +1991,34 @@ static struct ll_entry *get_dirty(struct r4300_core* r4300,u_int vaddr,u_int fla
   return NULL;
 }
 
+/* Cache statistics */
+#define STATS_LOG_PERIOD 8192 // compiled blocks, a power of 2
+
+void new_dynarec_set_cache_size(size_t size)
+{
+  // Power of 2, from 4 MB up to the whole cache
+  int size_2=22;
+  while(size_2<TARGET_SIZE_2&&((size_t)2<<size_2)<=size) size_2++;
+  cache_size_2_requested=size_2;
+}
+
+const struct new_dynarec_stats *new_dynarec_get_stats(void)
+{
+  return &stats;
+}
+
+static void log_stats(void)
+{
+  uint64_t lookups=stats.ht_hits[0]+stats.ht_hits[1]+stats.ht_misses;
+
+  if(stats.blocks_compiled==0) return;
+
+  DebugMessage(M64MSG_VERBOSE, "new_dynarec: %" PRIu64 " blocks compiled (%" PRIu64 " KB), %" PRIu64 " expired, %" PRIu64 " invalidations",
+               stats.blocks_compiled, stats.bytes_emitted>>10, stats.blocks_expired, stats.invalidations);
+  DebugMessage(M64MSG_VERBOSE, "new_dynarec: dirty blocks %" PRIu64 " restored, %" PRIu64 " stale; hash table %" PRIu64 " lookups, %" PRIu64 " in 2nd slot, %" PRIu64 " missed",
+               stats.dirty_hits, stats.dirty_misses, lookups, stats.ht_hits[1], stats.ht_misses);
+}
+
 static void *dyna_linker(void * src, u_int vaddr)
 {
   assert((vaddr&1)==0);
@@ -2007,7 +2071,7 @@ static void *dyna_linker(void * src, u_int vaddr)
   int r=new_recompile_block(vaddr);
   if(r==0) return dyna_linker(src,vaddr);
   // Execute in unmapped page, generate pagefault execption
-  assert(r4300->cp0.tlb.LUT_r[(vaddr&~1) >> 12] == 0);
+  assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, (vaddr&~1) >> 12) == 0);
   assert((intptr_t)r4300->new_dynarec_hot_state.memory_map[(vaddr&~1) >> 12] < 0);
   r4300->delay_slot = vaddr&1;
   TLB_refill_exception(r4300, vaddr&~1, 2);
@@ -2065,7 +2129,7 @@ static void *dyna_linker_ds(void * src, u_int vaddr)
   int r=new_recompile_block((vaddr&0xFFFFFFF8)+1);
   if(r==0) return dyna_linker_ds(src,vaddr);
   // Execute in unmapped page, generate pagefault execption
-  assert(r4300->cp0.tlb.LUT_r[(vaddr&~1) >> 12] == 0);
+  assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, (vaddr&~1) >> 12) == 0);
   assert((intptr_t)r4300->new_dynarec_hot_state.memory_map[(vaddr&~1) >> 12] < 0);
   r4300->delay_slot = vaddr&1;
   TLB_refill_exception(r4300, vaddr&~1, 2);
@@ -2103,7 +2167,7 @@ void *get_addr(u_int vaddr)
   int r=new_recompile_block(vaddr);
   if(r==0) return get_addr(vaddr);
   // Execute in unmapped page, generate pagefault execption
-  assert(r4300->cp0.tlb.LUT_r[(vaddr&~1) >> 12] == 0);
+  assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, (vaddr&~1) >> 12) == 0);
   assert((intptr_t)r4300->new_dynarec_hot_state.memory_map[(vaddr&~1) >> 12] < 0);
   r4300->delay_slot = vaddr&1;
   TLB_refill_exception(r4300, vaddr&~1, 2);
@@ -2114,8 +2178,15 @@ void *get_addr(u_int vaddr)
 void *get_addr_ht(u_int vaddr)
 {
   struct ll_entry **ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
-  if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[0]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
-  if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[1]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
+  if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
+    stats.ht_hits[0]++;
+    return (void *)(((intptr_t)ht_bin[0]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
+  }
+  if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) {
+    stats.ht_hits[1]++;
+    return (void *)(((intptr_t)ht_bin[1]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
+  }
+  stats.ht_misses++;
   return get_addr(vaddr);
 }
 
@@ -2154,7 +2225,7 @@ void *get_addr_32(u_int vaddr,u_int flags)
   int r=new_recompile_block(vaddr);
   if(r==0) return get_addr(vaddr);
   // Execute in unmapped page, generate pagefault execption
-  assert(r4300->cp0.tlb.LUT_r[(vaddr&~1) >> 12] == 0);
+  assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, (vaddr&~1) >> 12) == 0);
   assert((intptr_t)r4300->new_dynarec_hot_state.memory_map[(vaddr&~1) >> 12] < 0);
   r4300->delay_slot = vaddr&1;
   TLB_refill_exception(r4300, vaddr&~1, 2);
@@ -2168,11 +2239,11 @@ static void *check_addr(u_int vaddr)
   struct ll_entry **ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
 
   if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
-    if((((uintptr_t)ht_bin[0]->addr-MAX_OUTPUT_BLOCK_SIZE-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
+    if((((uintptr_t)ht_bin[0]->addr-MAX_OUTPUT_BLOCK_SIZE-(uintptr_t)out)<<(32-cache_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-cache_size_2)))
       if(ht_bin[0]->addr==ht_bin[0]->clean_addr) return ht_bin[0]->addr; //jump_in
   }
   if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) {
-    if((((uintptr_t)ht_bin[1]->addr-MAX_OUTPUT_BLOCK_SIZE-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
+    if((((uintptr_t)ht_bin[1]->addr-MAX_OUTPUT_BLOCK_SIZE-(uintptr_t)out)<<(32-cache_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-cache_size_2)))
       if(ht_bin[1]->addr==ht_bin[1]->clean_addr) return ht_bin[1]->addr; //jump_in
   }
 
@@ -2180,7 +2251,7 @@ static void *check_addr(u_int vaddr)
   struct ll_entry *head;
   head=get_clean(r4300,vaddr,~0);
   if(head!=NULL){
-    if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
+    if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-cache_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-cache_size_2))) {
       // Update existing entry with current address
       if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
         ht_bin[0]=head;
@@ -2238,9 +2309,11 @@ void invalidate_block(u_int block)
 {
   u_int page;
   page=block^0x80000;
-  if(page>262143&&g_dev.r4300.cp0.tlb.LUT_r[block]) page=(g_dev.r4300.cp0.tlb.LUT_r[block]^0x80000000)>>12;
+  if(page>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, block)) page=(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, block)^0x80000000)>>12;
   if(page>2048) page=2048+(page&2047);
   inv_debug("INVALIDATE: %x (%d)\n",block<<12,page);
+  stats.invalidations++;
+  if(page<2048) g_dev.r4300.cached_interp.invalidations[page]++;
   u_int first,last;
   first=last=page;
   struct ll_entry *head;
@@ -2296,14 +2369,16 @@ void invalidate_block(u_int block)
   // Don't trap writes
   g_dev.r4300.cached_interp.invalid_code[block]=1;
   // If there is a valid TLB entry for this page, remove write protect
-  if(g_dev.r4300.cp0.tlb.LUT_w[block]) {
-    assert(g_dev.r4300.cp0.tlb.LUT_r[block]==g_dev.r4300.cp0.tlb.LUT_w[block]);
-    g_dev.r4300.new_dynarec_hot_state.memory_map[block]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((g_dev.r4300.cp0.tlb.LUT_w[block]&0xFFFFF000)-0x80000000)-(block<<12))>>2;
-    u_int real_block=g_dev.r4300.cp0.tlb.LUT_w[block]>>12;
+  if(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_w, block)) {
+    assert(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, block)==tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_w, block));
+    g_dev.r4300.new_dynarec_hot_state.memory_map[block]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_w, block)&0xFFFFF000)-0x80000000)-(block<<12))>>2;
+    u_int real_block=tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_w, block)>>12;
     g_dev.r4300.cached_interp.invalid_code[real_block]=1;
     if(real_block>=0x80000&&real_block<0x80800) g_dev.r4300.new_dynarec_hot_state.memory_map[real_block]=((uintptr_t)g_dev.rdram.dram-(uintptr_t)0x80000000)>>2;
+    ram_hooks_apply(real_block);
   }
   else if(block>=0x80000&&block<0x80800) g_dev.r4300.new_dynarec_hot_state.memory_map[block]=((uintptr_t)g_dev.rdram.dram-(uintptr_t)0x80000000)>>2;
+  ram_hooks_apply(block);
   #ifdef USE_MINI_HT
   memset(g_dev.r4300.new_dynarec_hot_state.mini_ht,-1,sizeof(g_dev.r4300.new_dynarec_hot_state.mini_ht));
   #endif
@@ -2331,9 +2406,9 @@ static void invalidate_all_pages(void)
   #endif
   // TLB
   for(page=0;page<0x100000;page++) {
-    if(g_dev.r4300.cp0.tlb.LUT_r[page]) {
-      g_dev.r4300.new_dynarec_hot_state.memory_map[page]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((g_dev.r4300.cp0.tlb.LUT_r[page]&0xFFFFF000)-0x80000000)-(page<<12))>>2;
-      if(!g_dev.r4300.cp0.tlb.LUT_w[page]||!g_dev.r4300.cached_interp.invalid_code[page])
+    if(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, page)) {
+      g_dev.r4300.new_dynarec_hot_state.memory_map[page]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, page)&0xFFFFF000)-0x80000000)-(page<<12))>>2;
+      if(!tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_w, page)||!g_dev.r4300.cached_interp.invalid_code[page])
         g_dev.r4300.new_dynarec_hot_state.memory_map[page]|=WRITE_PROTECT; // Write protect
     }
     else g_dev.r4300.new_dynarec_hot_state.memory_map[page]=(uintptr_t)-1;
@@ -2365,6 +2440,39 @@ void invalidate_cached_code_new_dynarec(struct r4300_core* r4300, uint32_t addre
     }
 }
 
+// Drops all the compiled code, without keeping it for a later restore
+static void flush_all_blocks(void)
+{
+  int n;
+  invalidate_all_pages();
+  for(n=0;n<4096;n++) ll_clear(jump_dirty+n);
+  for(n=0;n<65536;n++)
+    hash_table[n][0]=hash_table[n][1]=NULL;
+  memset(g_dev.r4300.new_dynarec_hot_state.restore_candidate,0,sizeof(g_dev.r4300.new_dynarec_hot_state.restore_candidate));
+}
+
+void new_dynarec_update_ram_hooks(void)
+{
+  const uint8_t *pages=g_dev.r4300.hooks.ram_pages;
+  int n,hooked=0,flush=0;
+  if(!ram_hooks_running) return;
+  for(n=0;n<2048;n++) {
+    if(pages[n]) hooked=1;
+    // Constant loads from a newly read hooked page were inlined
+    if(pages[n]&~ram_hook_pages[n]&R4300_HOOK_RAM_READ) flush=1;
+  }
+  // Without the TLB, the blocks compiled before the first hook don't look
+  // at memory_map at all, and the ones compiled while there were hooks
+  // don't need to once the last one is gone
+  if(hooked!=ram_hooks_lookup&&!using_tlb) flush=1;
+  memcpy(ram_hook_pages,pages,sizeof(ram_hook_pages));
+  if(hooked!=ram_hooks_lookup)
+    DebugMessage(M64MSG_VERBOSE, hooked?"Looking up memory_map for RAM hooks":"No more RAM hooks");
+  ram_hooks_lookup=hooked;
+  if(flush) flush_all_blocks();
+  for(n=0;n<2048;n++) ram_hooks_apply(0x80000+n);
+}
+
 // If a code block was found to be unmodified (bit was set in
 // restore_candidate) and it remains unmodified (bit is clear
 // in invalid_code) then move the entries for that 4K page from
@@ -2377,7 +2485,7 @@ void clean_blocks(u_int page)
   while(head!=NULL) {
     if(!g_dev.r4300.cached_interp.invalid_code[head->vaddr>>12]) {
       // Don't restore blocks which are about to expire from the cache
-      if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
+      if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-cache_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-cache_size_2))) {
         if(verify_dirty(head)==0) {
           //DebugMessage(M64MSG_VERBOSE, "Possibly Restore %x (%x)",head->vaddr, (intptr_t)head->addr);
           u_int i,j;
@@ -2406,9 +2514,9 @@ void clean_blocks(u_int page)
             inv=1;
           }
           if(!inv) {
-            if((((uintptr_t)head->clean_addr-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
+            if((((uintptr_t)head->clean_addr-(uintptr_t)out)<<(32-cache_size_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-cache_size_2))) {
               u_int ppage=page;
-              if(page<2048&&g_dev.r4300.cp0.tlb.LUT_r[head->vaddr>>12]) ppage=(g_dev.r4300.cp0.tlb.LUT_r[head->vaddr>>12]^0x80000000)>>12;
+              if(page<2048&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, head->vaddr>>12)) ppage=(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, head->vaddr>>12)^0x80000000)>>12;
               inv_debug("INV: Restored %x (%x/%x)\n",head->vaddr, (intptr_t)head->addr, (intptr_t)head->clean_addr);
               //DebugMessage(M64MSG_VERBOSE, "page=%x, addr=%x",page,head->vaddr);
               //assert(head->vaddr>>12==(page|0x80000));
@@ -2746,7 +2854,7 @@ static void load_alloc(struct regstat *current,int i)
       alloc_reg64(current,i,FTEMP);
 
     // If using TLB, need a register for pointer to the mapping table
-    if(using_tlb) alloc_reg(current,i,TLREG);
+    if(block_tlb) alloc_reg(current,i,TLREG);
 
     alloc_reg_temp(current,i,-1);
     minimum_free_regs[i]=1;
@@ -2761,7 +2869,7 @@ static void load_alloc(struct regstat *current,int i)
       alloc_reg64(current,i,FTEMP);
 
     // If using TLB, need a register for pointer to the mapping table
-    if(using_tlb) alloc_reg(current,i,TLREG);
+    if(block_tlb) alloc_reg(current,i,TLREG);
 
     alloc_reg_temp(current,i,-1);
     minimum_free_regs[i]=1;
@@ -2779,7 +2887,7 @@ static void store_alloc(struct regstat *current,int i)
     if(rs2[i]) alloc_reg(current,i,FTEMP);
   }
   // If using TLB, need a register for pointer to the mapping table
-  if(using_tlb) alloc_reg(current,i,TLREG);
+  if(block_tlb) alloc_reg(current,i,TLREG);
   #if defined(HOST_IMM8) || defined(NEED_INVC_PTR)
   // On CPUs without 32-bit immediates we need a pointer to invalid_code
   else alloc_reg(current,i,INVCP);
@@ -2803,7 +2911,7 @@ static void c1ls_alloc(struct regstat *current,int i)
     alloc_reg64(current,i,FTEMP);
   }
   // If using TLB, need a register for pointer to the mapping table
-  if(using_tlb) alloc_reg(current,i,TLREG);
+  if(block_tlb) alloc_reg(current,i,TLREG);
   #if defined(HOST_IMM8) || defined(NEED_INVC_PTR)
   // On CPUs without 32-bit immediates we need a pointer to invalid_code
   else if((opcode[i]&0x3b)==0x39) // SWC1/SDC1
@@ -3870,6 +3978,7 @@ static void load_assemble(int i,struct regstat *i_regs)
 #ifndef INTERPRET_LOAD
     memtarget=((signed int)(constmap[i][s]+offset))<(signed int)0x80800000;
     if(using_tlb&&((signed int)(constmap[i][s]+offset))>=(signed int)0xC0000000) memtarget=1;
+    if(ram_read_hooked(constmap[i][s]+offset)) memtarget=0;
 #endif
   }
 
@@ -3879,7 +3988,7 @@ static void load_assemble(int i,struct regstat *i_regs)
   if(offset||s<0||c) addr=temp;
   else addr=s;
   assert(tl>=0); // Even if the load is a NOP, we must check for pagefaults and I/O
-  if(!using_tlb) {
+  if(!block_tlb) {
     if(!c) {
 //#define R29_HACK 1
       #ifdef R29_HACK
@@ -4106,7 +4215,7 @@ static void store_assemble(int i,struct regstat *i_regs)
   if(i_regs->regmap[HOST_CCREG]==CCREG) reglist&=~(1<<HOST_CCREG);
   if(offset||s<0||c) addr=temp;
   else addr=s;
-  if(!using_tlb) {
+  if(!block_tlb) {
     if(!c) {
       #ifdef R29_HACK
       // Strmnnrmn's speed hack
@@ -4191,7 +4300,7 @@ static void store_assemble(int i,struct regstat *i_regs)
     }
     type=STORED_STUB;
   }
-  if(!using_tlb) {
+  if(!block_tlb) {
     if(!c||memtarget) {
       #ifdef DESTRUCTIVE_SHIFT
       // The x86 shift operation is 'destructive'; it overwrites the
@@ -4252,7 +4361,7 @@ static void storelr_assemble(int i,struct regstat *i_regs)
     if(i_regs->regmap[hr]>=0) reglist|=1<<hr;
   }
   assert(temp>=0);
-  if(!using_tlb) {
+  if(!block_tlb) {
     if(!c) {
       emit_cmpimm(s<0||offset?temp:s,0x800000);
       if(!offset&&s!=temp) emit_mov(s,temp);
@@ -4435,7 +4544,7 @@ static void storelr_assemble(int i,struct regstat *i_regs)
     emit_writeword_indexed_tlb(temp2,-4,temp,map);
     set_jump_target(done0,(intptr_t)out);
   }
-  if(!using_tlb) {
+  if(!block_tlb) {
     #if NEW_DYNAREC >= NEW_DYNAREC_ARM
     map=get_reg(i_regs->regmap,ROREG);
     if(map>=0) emit_loadreg(ROREG,map);
@@ -4514,7 +4623,7 @@ static void c1ls_assemble(int i,struct regstat *i_regs)
     emit_readptr((intptr_t)&r4300_cp1_regs_double(&g_dev.r4300.cp1)[(source[i]>>16)&0x1f],tl);
   }
   // Generate address + offset
-  if(!using_tlb) {
+  if(!block_tlb) {
     #ifdef RAM_OFFSET
     #ifndef NATIVE_64
     if (!c||opcode[i]==0x39||opcode[i]==0x3D) // SWC1/SDC1
@@ -4553,7 +4662,7 @@ static void c1ls_assemble(int i,struct regstat *i_regs)
   if (opcode[i]==0x35) { // LDC1 (get target address)
     emit_readptr((intptr_t)&r4300_cp1_regs_double(&g_dev.r4300.cp1)[(source[i]>>16)&0x1f],temp);
   }
-  if(!using_tlb) {
+  if(!block_tlb) {
     if(!c) {
       jaddr2=(intptr_t)out;
       emit_jno(0);
@@ -4569,7 +4678,12 @@ static void c1ls_assemble(int i,struct regstat *i_regs)
     #endif
   }else{
     if (opcode[i]==0x31||opcode[i]==0x35) { // LWC1/LDC1
-      do_tlb_r_branch(map,c,constmap[i][s]+offset,&jaddr2);
+      if(c&&ram_read_hooked(constmap[i][s]+offset)) {
+        jaddr2=(intptr_t)out;
+        emit_jmp(0); // Read hooked page, always use the stub
+      }
+      else
+        do_tlb_r_branch(map,c,constmap[i][s]+offset,&jaddr2);
     }
     if (opcode[i]==0x39||opcode[i]==0x3D) { // SWC1/SDC1
       do_tlb_w_branch(map,c,constmap[i][s]+offset,&jaddr2);
@@ -4603,7 +4717,7 @@ static void c1ls_assemble(int i,struct regstat *i_regs)
     emit_writedword_indexed_tlb(th,tl,0,offset||c||s<0?temp:s,map);
     type=STORED_STUB;
   }
-  if(!using_tlb) {
+  if(!block_tlb) {
     if (opcode[i]==0x39||opcode[i]==0x3D) { // SWC1/SDC1
       #ifndef DESTRUCTIVE_SHIFT
       temp=offset||c||s<0?ar:s;
@@ -7350,9 +7464,9 @@ static void pagespan_ds(void)
   u_int vaddr=start+1;
   u_int page=(0x80000000^vaddr)>>12;
   u_int vpage=page;
-  if(page>262143&&g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]) page=(g_dev.r4300.cp0.tlb.LUT_r[page^0x80000]^0x80000000)>>12;
+  if(page>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)) page=(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, page^0x80000)^0x80000000)>>12;
   if(page>2048) page=2048+(page&2047);
-  if(vpage>262143&&g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
+  if(vpage>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
   if(vpage>2048) vpage=2048+(vpage&2047);
   struct ll_entry *head=ll_add(jump_dirty+vpage,vaddr,(void *)out,NULL,start,copy,slen*4);
   dirty_entry_count++;
@@ -7591,6 +7705,11 @@ void new_dynarec_init(void)
 #endif
 
   if(base_addr==(void*)-1) DebugMessage(M64MSG_ERROR, "mmap() failed");
+  else {
+    // Large and hot, ask for large pages to spare the host TLB
+    size_t cache_pages=osal_advise_large_pages(base_addr,1<<TARGET_SIZE_2);
+    DebugMessage(M64MSG_INFO, "Translation cache on %u KB pages",(unsigned int)(cache_pages/1024));
+  }
 
   assert(((uintptr_t)g_dev.rdram.dram&7)==0); //8 bytes aligned 
   out=(u_char *)base_addr;
@@ -7626,6 +7745,16 @@ void new_dynarec_init(void)
 
   tlb_speed_hacks();
   arch_init();
+
+  cache_size_2=cache_size_2_requested;
+  memset(&stats,0,sizeof(stats));
+  if(cache_size_2!=TARGET_SIZE_2)
+    DebugMessage(M64MSG_INFO, "Using %d MB of the translation cache", 1<<(cache_size_2-20));
+
+  ram_hooks_running=1;
+  ram_hooks_lookup=0;
+  memset(ram_hook_pages,0,sizeof(ram_hook_pages));
+  new_dynarec_update_ram_hooks();
 }
 
 void new_dynarec_cleanup(void)
@@ -7634,6 +7763,9 @@ void new_dynarec_cleanup(void)
   recomp_dbg_cleanup();
 #endif
 
+  ram_hooks_running=0;
+  log_stats();
+
   int n;
   for(n=0;n<4096;n++) ll_clear(jump_in+n);
   for(n=0;n<4096;n++) ll_clear(jump_out+n);
@@ -7676,8 +7808,8 @@ int new_recompile_block(int addr)
   }
   else if ((signed int)addr >= (signed int)0xC0000000) {
     //DebugMessage(M64MSG_VERBOSE, "addr=%x mm=%x",(u_int)addr,(g_dev.r4300.new_dynarec_hot_state.memory_map[start>>12]<<2));
-    //if(g_dev.r4300.cp0.tlb.LUT_r[start>>12])
-    //source = (u_int *)(((intptr_t)g_dev.rdram.dram)+(g_dev.r4300.cp0.tlb.LUT_r[start>>12]&0xFFFFF000)+(((int)addr)&0xFFF)-(intptr_t)0x80000000);
+    //if(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, start>>12))
+    //source = (u_int *)(((intptr_t)g_dev.rdram.dram)+(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, start>>12)&0xFFFFF000)+(((int)addr)&0xFFF)-(intptr_t)0x80000000);
     if((intptr_t)g_dev.r4300.new_dynarec_hot_state.memory_map[start>>12]>=0) {
       source = (u_int *)((uintptr_t)(start+(uintptr_t)(g_dev.r4300.new_dynarec_hot_state.memory_map[start>>12]<<2)));
       pagelimit=(start+4096)&0xFFFFF000;
@@ -8254,6 +8386,16 @@ int new_recompile_block(int addr)
   }
   assert(slen>0);
 
+  // With RAM hooks, only the blocks which may access memory look it up
+  // through memory_map, the others keep the direct RDRAM accesses
+  block_tlb=using_tlb;
+  if(ram_hooks_lookup) {
+    for(i=0;i<slen;i++) {
+      if(itype[i]==LOAD||itype[i]==LOADLR||itype[i]==STORE||itype[i]==STORELR||itype[i]==C1LS)
+        block_tlb=1;
+    }
+  }
+
   /* Pass 2 - Register dependencies and branch targets */
 
   unneeded_registers(0,slen-1,0);
@@ -9421,7 +9563,7 @@ int new_recompile_block(int addr)
             d1=dep1[i+1];
             d2=dep2[i+1];
           }
-          if(using_tlb) {
+          if(block_tlb) {
             if(itype[i+1]==LOAD || itype[i+1]==LOADLR ||
                itype[i+1]==STORE || itype[i+1]==STORELR ||
                itype[i+1]==C1LS )
@@ -9480,7 +9622,7 @@ int new_recompile_block(int addr)
               d1=dep1[i];
               d2=dep2[i];
             }
-            if(using_tlb) {
+            if(block_tlb) {
               if(itype[i]==LOAD || itype[i]==LOADLR ||
                  itype[i]==STORE || itype[i]==STORELR ||
                  itype[i]==C1LS )
@@ -9873,14 +10015,14 @@ int new_recompile_block(int addr)
   // Cache memory offset or tlb map pointer if a register is available
   #ifndef HOST_IMM_ADDR32
   #ifndef RAM_OFFSET
-  if(using_tlb)
+  if(block_tlb)
   #endif
   {
     int earliest_available[HOST_REGS];
     int loop_start[HOST_REGS];
     int score[HOST_REGS];
     int end[HOST_REGS];
-    int reg=using_tlb?MMREG:ROREG;
+    int reg=block_tlb?MMREG:ROREG;
 
     // Init
     for(hr=0;hr<HOST_REGS;hr++) {
@@ -10823,9 +10965,9 @@ int new_recompile_block(int addr)
         u_int vaddr=start+i*4;
         u_int page=(0x80000000^vaddr)>>12;
         u_int vpage=page;
-        if(page>262143&&g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]) page=(g_dev.r4300.cp0.tlb.LUT_r[page^0x80000]^0x80000000)>>12;
+        if(page>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)) page=(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, page^0x80000)^0x80000000)>>12;
         if(page>2048) page=2048+(page&2047);
-        if(vpage>262143&&g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
+        if(vpage>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
         if(vpage>2048) vpage=2048+(vpage&2047);
         literal_pool(256);
         //if(!(is32[i]&(~unneeded_reg_upper[i])&~(1LL<<CCREG)))
@@ -10887,11 +11029,18 @@ int new_recompile_block(int addr)
   intptr_t beginning_rx=((intptr_t)beginning-(intptr_t)base_addr)+(intptr_t)base_addr_rx;
   intptr_t out_rx=((intptr_t)out-(intptr_t)base_addr)+(intptr_t)base_addr_rx;
   cache_flush((char *)beginning_rx,(char *)out_rx);
+  perf_map_add((void *)beginning_rx,(uintptr_t)out-beginning,start);
+  #else
+  perf_map_add((void *)beginning,(uintptr_t)out-beginning,start);
   #endif
 
+  stats.blocks_compiled++;
+  stats.bytes_emitted+=(uintptr_t)out-beginning;
+  if((stats.blocks_compiled&(STATS_LOG_PERIOD-1))==0) log_stats();
+
   // If we're within 256K of the end of the buffer,
   // start over from the beginning. (Is 256K enough?)
-  if(out > (u_char *)((u_char *)base_addr+(1<<TARGET_SIZE_2)-MAX_OUTPUT_BLOCK_SIZE-JUMP_TABLE_SIZE))
+  if(out > (u_char *)((u_char *)base_addr+(1<<cache_size_2)-MAX_OUTPUT_BLOCK_SIZE-JUMP_TABLE_SIZE))
     out=(u_char *)base_addr;
   
   // Trap writes to any of the pages we compiled
@@ -10910,20 +11059,20 @@ int new_recompile_block(int addr)
   
   /* Pass 10 - Free memory by expiring oldest blocks */
   
-  int end=((((intptr_t)out-(intptr_t)base_addr)>>(TARGET_SIZE_2-16))+16384)&65535;
+  int end=((((intptr_t)out-(intptr_t)base_addr)>>(cache_size_2-16))+16384)&65535;
   while(expirep!=end)
   {
-    int shift=TARGET_SIZE_2-3; // Divide into 8 blocks
+    int shift=cache_size_2-3; // Divide into 8 blocks
     intptr_t base=(intptr_t)base_addr+((expirep>>13)<<shift); // Base address of this block
     inv_debug("EXP: Phase %d\n",expirep);
     switch((expirep>>11)&3)
     {
       case 0:
         // Clear jump_in and jump_dirty
-        ll_remove_matching_addrs(jump_in+(expirep&2047),base,shift);
-        ll_remove_matching_addrs(jump_dirty+(expirep&2047),base,shift);
-        ll_remove_matching_addrs(jump_in+2048+(expirep&2047),base,shift);
-        ll_remove_matching_addrs(jump_dirty+2048+(expirep&2047),base,shift);
+        stats.blocks_expired+=ll_remove_matching_addrs(jump_in+(expirep&2047),base,shift);
+        stats.blocks_expired+=ll_remove_matching_addrs(jump_dirty+(expirep&2047),base,shift);
+        stats.blocks_expired+=ll_remove_matching_addrs(jump_in+2048+(expirep&2047),base,shift);
+        stats.blocks_expired+=ll_remove_matching_addrs(jump_dirty+2048+(expirep&2047),base,shift);
         break;
       case 1:
         // Clear pointers
@@ -11034,16 +11183,16 @@ static void TLBWI_new(int pcaddr, int count, int diff)
      for fast look up. */
   for (i=r4300->cp0.tlb.entries[r4300_cp0_regs(&r4300->cp0)[CP0_INDEX_REG]&0x3F].start_even>>12; i<=r4300->cp0.tlb.entries[r4300_cp0_regs(&r4300->cp0)[CP0_INDEX_REG]&0x3F].end_even>>12; i++)
   {
-    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,r4300->cp0.tlb.LUT_r[i],r4300->cp0.tlb.LUT_w[i]);
+    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,tlb_lut_get(&r4300->cp0.tlb.LUT_r, i),tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
     if(i<0x80000||i>0xBFFFF)
     {
-      if(r4300->cp0.tlb.LUT_r[i]) {
-        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((r4300->cp0.tlb.LUT_r[i]&0xFFFFF000)-0x80000000)-(i<<12))>>2;
+      if(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)) {
+        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)&0xFFFFF000)-0x80000000)-(i<<12))>>2;
         // FIXME: should make sure the physical page is invalid too
-        if(!r4300->cp0.tlb.LUT_w[i]||!r4300->cached_interp.invalid_code[i]) {
+        if(!tlb_lut_get(&r4300->cp0.tlb.LUT_w, i)||!r4300->cached_interp.invalid_code[i]) {
           state->memory_map[i]|=WRITE_PROTECT; // Write protect
         }else{
-          assert(r4300->cp0.tlb.LUT_r[i]==r4300->cp0.tlb.LUT_w[i]);
+          assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)==tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
         }
         if(!using_tlb) DebugMessage(M64MSG_VERBOSE, "Enabled TLB");
         // Tell the dynamic recompiler to generate tlb lookup code
@@ -11055,16 +11204,16 @@ static void TLBWI_new(int pcaddr, int count, int diff)
   }
   for (i=r4300->cp0.tlb.entries[r4300_cp0_regs(&r4300->cp0)[CP0_INDEX_REG]&0x3F].start_odd>>12; i<=r4300->cp0.tlb.entries[r4300_cp0_regs(&r4300->cp0)[CP0_INDEX_REG]&0x3F].end_odd>>12; i++)
   {
-    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,r4300->cp0.tlb.LUT_r[i],r4300->cp0.tlb.LUT_w[i]);
+    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,tlb_lut_get(&r4300->cp0.tlb.LUT_r, i),tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
     if(i<0x80000||i>0xBFFFF)
     {
-      if(r4300->cp0.tlb.LUT_r[i]) {
-        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((r4300->cp0.tlb.LUT_r[i]&0xFFFFF000)-0x80000000)-(i<<12))>>2;
+      if(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)) {
+        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)&0xFFFFF000)-0x80000000)-(i<<12))>>2;
         // FIXME: should make sure the physical page is invalid too
-        if(!r4300->cp0.tlb.LUT_w[i]||!r4300->cached_interp.invalid_code[i]) {
+        if(!tlb_lut_get(&r4300->cp0.tlb.LUT_w, i)||!r4300->cached_interp.invalid_code[i]) {
           state->memory_map[i]|=WRITE_PROTECT; // Write protect
         }else{
-          assert(r4300->cp0.tlb.LUT_r[i]==r4300->cp0.tlb.LUT_w[i]);
+          assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)==tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
         }
         if(!using_tlb) DebugMessage(M64MSG_VERBOSE, "Enabled TLB");
         // Tell the dynamic recompiler to generate tlb lookup code
@@ -11115,16 +11264,16 @@ static void TLBWR_new(int pcaddr, int count, int diff)
      for fast look up. */
   for (i=r4300->cp0.tlb.entries[r4300_cp0_regs(&r4300->cp0)[CP0_RANDOM_REG]&0x3F].start_even>>12; i<=r4300->cp0.tlb.entries[r4300_cp0_regs(&r4300->cp0)[CP0_RANDOM_REG]&0x3F].end_even>>12; i++)
   {
-    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,r4300->cp0.tlb.LUT_r[i],r4300->cp0.tlb.LUT_w[i]);
+    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,tlb_lut_get(&r4300->cp0.tlb.LUT_r, i),tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
     if(i<0x80000||i>0xBFFFF)
     {
-      if(r4300->cp0.tlb.LUT_r[i]) {
-        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((r4300->cp0.tlb.LUT_r[i]&0xFFFFF000)-0x80000000)-(i<<12))>>2;
+      if(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)) {
+        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)&0xFFFFF000)-0x80000000)-(i<<12))>>2;
         // FIXME: should make sure the physical page is invalid too
-        if(!r4300->cp0.tlb.LUT_w[i]||!r4300->cached_interp.invalid_code[i]) {
+        if(!tlb_lut_get(&r4300->cp0.tlb.LUT_w, i)||!r4300->cached_interp.invalid_code[i]) {
           state->memory_map[i]|=WRITE_PROTECT; // Write protect
         }else{
-          assert(r4300->cp0.tlb.LUT_r[i]==r4300->cp0.tlb.LUT_w[i]);
+          assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)==tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
         }
         if(!using_tlb) DebugMessage(M64MSG_VERBOSE, "Enabled TLB");
         // Tell the dynamic recompiler to generate tlb lookup code
@@ -11136,16 +11285,16 @@ static void TLBWR_new(int pcaddr, int count, int diff)
   }
   for (i=r4300->cp0.tlb.entries[r4300_cp0_regs(&r4300->cp0)[CP0_RANDOM_REG]&0x3F].start_odd>>12; i<=r4300->cp0.tlb.entries[r4300_cp0_regs(&r4300->cp0)[CP0_RANDOM_REG]&0x3F].end_odd>>12; i++)
   {
-    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,r4300->cp0.tlb.LUT_r[i],r4300->cp0.tlb.LUT_w[i]);
+    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,tlb_lut_get(&r4300->cp0.tlb.LUT_r, i),tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
     if(i<0x80000||i>0xBFFFF)
     {
-      if(r4300->cp0.tlb.LUT_r[i]) {
-        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((r4300->cp0.tlb.LUT_r[i]&0xFFFFF000)-0x80000000)-(i<<12))>>2;
+      if(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)) {
+        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)&0xFFFFF000)-0x80000000)-(i<<12))>>2;
         // FIXME: should make sure the physical page is invalid too
-        if(!r4300->cp0.tlb.LUT_w[i]||!r4300->cached_interp.invalid_code[i]) {
+        if(!tlb_lut_get(&r4300->cp0.tlb.LUT_w, i)||!r4300->cached_interp.invalid_code[i]) {
           state->memory_map[i]|=WRITE_PROTECT; // Write protect
         }else{
-          assert(r4300->cp0.tlb.LUT_r[i]==r4300->cp0.tlb.LUT_w[i]);
+          assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)==tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
         }
         if(!using_tlb) DebugMessage(M64MSG_VERBOSE, "Enabled TLB");
         // Tell the dynamic recompiler to generate tlb lookup code
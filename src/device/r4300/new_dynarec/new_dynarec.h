@@ -36,6 +36,19 @@
 
 struct r4300_core;
 
+/* Counters of the new_dynarec translation cache, since new_dynarec_init */
+struct new_dynarec_stats
+{
+    uint64_t blocks_compiled;
+    uint64_t bytes_emitted;
+    uint64_t blocks_expired;
+    uint64_t invalidations;
+    uint64_t dirty_hits;
+    uint64_t dirty_misses;
+    uint64_t ht_hits[2];
+    uint64_t ht_misses;
+};
+
 /* This struct contains "hot" variables used by the new_dynarec
  *
  * For the ARM version, care has been taken to place struct members at offsets within LDR/STR offsets ranges.
@@ -93,5 +106,8 @@ void invalidate_cached_code_new_dynarec(struct r4300_core* r4300, uint32_t addre
 void new_dynarec_init(void);
 void new_dyna_start(void);
 void new_dynarec_cleanup(void);
+void new_dynarec_set_cache_size(size_t size);
+void new_dynarec_update_ram_hooks(void);
+const struct new_dynarec_stats* new_dynarec_get_stats(void);
 
 #endif /* M64P_DEVICE_R4300_NEW_DYNAREC_H */
@@ -3674,6 +3674,7 @@ static void loadlr_assemble_x64(int i,struct regstat *i_regs)
     c=(i_regs->wasconst>>s)&1;
     memtarget=((signed int)(constmap[i][s]+offset))<(signed int)0x80800000;
     if(using_tlb&&((signed int)(constmap[i][s]+offset))>=(signed int)0xC0000000) memtarget=1;
+    if(ram_read_hooked(constmap[i][s]+offset)) memtarget=0;
   }
   if(!using_tlb) {
     if(!c) {
@@ -0,0 +1,245 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - polling_loop.c                                          *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "polling_loop.h"
+
+#include "device/device.h"
+#include "device/r4300/r4300_core.h"
+#include "main/list.h"
+
+/* register numbers used for the dependency masks, after the 32 GPRs */
+enum { REG_HI = 32, REG_LO = 33 };
+
+#define REG_BIT(reg) (UINT64_C(1) << (reg))
+
+#define RS_OF(iw) (((iw) >> 21) & 0x1f)
+#define RT_OF(iw) (((iw) >> 16) & 0x1f)
+#define RD_OF(iw) (((iw) >> 11) & 0x1f)
+
+static int is_unmapped(uint32_t address)
+{
+    return (address & UINT32_C(0xc0000000)) == UINT32_C(0x80000000);
+}
+
+/* returns 1 for LB, LH, LW, LBU, LHU, LWU and LD */
+static int is_load(uint32_t iw)
+{
+    switch (iw >> 26)
+    {
+    case 32: case 33: case 35: case 36: case 37: case 39: case 55:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* Gets the registers read and written by a side-effect free instruction.
+ * Returns 0 for any other instruction. */
+static int get_body_regs(uint32_t iw, uint64_t* reads, uint64_t* writes)
+{
+    if (is_load(iw))
+    {
+        *reads = REG_BIT(RS_OF(iw));
+        *writes = REG_BIT(RT_OF(iw));
+        return 1;
+    }
+
+    switch (iw >> 26)
+    {
+    case 0: /* SPECIAL */
+        switch (iw & 0x3f)
+        {
+        /* SLL, SRL, SRA, DSLL, DSRL, DSRA, DSLL32, DSRL32, DSRA32 */
+        case 0: case 2: case 3: case 56: case 58: case 59: case 60: case 62: case 63:
+            *reads = REG_BIT(RT_OF(iw));
+            break;
+        /* SLLV, SRLV, SRAV, DSLLV, DSRLV, DSRAV */
+        case 4: case 6: case 7: case 20: case 22: case 23:
+        /* ADDU, SUBU, AND, OR, XOR, NOR, SLT, SLTU, DADDU, DSUBU */
+        case 33: case 35: case 36: case 37: case 38: case 39: case 42: case 43: case 45: case 47:
+            *reads = REG_BIT(RS_OF(iw)) | REG_BIT(RT_OF(iw));
+            break;
+        case 16: /* MFHI */
+            *reads = REG_BIT(REG_HI);
+            break;
+        case 18: /* MFLO */
+            *reads = REG_BIT(REG_LO);
+            break;
+        default:
+            return 0;
+        }
+        *writes = REG_BIT(RD_OF(iw));
+        return 1;
+
+    /* ADDIU, SLTI, SLTIU, ANDI, ORI, XORI, DADDIU */
+    case 9: case 10: case 11: case 12: case 13: case 14: case 25:
+        *reads = REG_BIT(RS_OF(iw));
+        *writes = REG_BIT(RT_OF(iw));
+        return 1;
+
+    case 15: /* LUI */
+        *reads = 0;
+        *writes = REG_BIT(RT_OF(iw));
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+/* Gets the registers read by a conditional branch which doesn't link.
+ * Returns 0 for any other instruction. */
+static int get_branch_regs(uint32_t iw, uint64_t* reads)
+{
+    switch (iw >> 26)
+    {
+    case 1: /* REGIMM: BLTZ, BGEZ, BLTZL, BGEZL */
+        if (RT_OF(iw) > 3) {
+            return 0;
+        }
+        *reads = REG_BIT(RS_OF(iw));
+        return 1;
+    /* BEQ, BNE, BEQL, BNEL */
+    case 4: case 5: case 20: case 21:
+        *reads = REG_BIT(RS_OF(iw)) | REG_BIT(RT_OF(iw));
+        return 1;
+    /* BLEZ, BGTZ, BLEZL, BGTZL */
+    case 6: case 7: case 22: case 23:
+        *reads = REG_BIT(RS_OF(iw));
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+int polling_loop_detect(struct r4300_core* r4300, uint32_t pc, uint32_t target)
+{
+    /* registers read before being written in an iteration, and written */
+    uint64_t inputs = 0;
+    uint64_t outputs = 0;
+    /* base registers of the loads seen so far */
+    uint64_t bases = 0;
+    uint64_t reads, writes;
+    uint32_t address;
+    const uint32_t* iw;
+
+    if (!r4300->skip_polling_loops) {
+        return 0;
+    }
+
+    if (!is_unmapped(pc) || !is_unmapped(target) || target >= pc
+     || (pc - target) / 4 + 2 > POLLING_LOOP_MAX_LENGTH) {
+        return 0;
+    }
+
+    /* the loop body, the branch, then its delay slot */
+    for (address = target; address <= pc + 4; address += 4)
+    {
+        iw = fast_mem_access(r4300, address);
+
+        if (address == pc)
+        {
+            if (!get_branch_regs(*iw, &reads)) {
+                return 0;
+            }
+            writes = 0;
+        }
+        else if (!get_body_regs(*iw, &reads, &writes)) {
+            return 0;
+        }
+
+        /* polling_loop_can_skip computes load addresses from the registers
+         * at the end of the iteration, so they must still hold the base */
+        if (is_load(*iw)) {
+            bases |= REG_BIT(RS_OF(*iw));
+        }
+        if (writes & bases & ~REG_BIT(0)) {
+            return 0;
+        }
+
+        inputs |= reads & ~outputs;
+        outputs |= writes & ~REG_BIT(0);
+    }
+
+    /* an input changed by the loop would make iterations differ */
+    return (inputs & outputs) == 0;
+}
+
+/* Checks whether a physical address only changes on an interrupt event */
+static int is_polled_address(const struct device* dev, uint32_t address)
+{
+    if (address < MM_RDRAM_REGS) {
+        /* the RSP worker writes RDRAM without an interrupt event */
+        return !dev->sp.task_pending;
+    }
+
+    switch (address & ~UINT32_C(0xffff))
+    {
+    case MM_RSP_REGS:
+        return rsp_reg(address) == SP_STATUS_REG || rsp_reg(address) == SP_DMA_BUSY_REG;
+    case MM_DPC_REGS:
+        return dpc_reg(address) == DPC_STATUS_REG;
+    case MM_MI_REGS:
+        return mi_reg(address) == MI_INTR_REG;
+    case MM_PI_REGS:
+        return pi_reg(address) == PI_STATUS_REG;
+    case MM_SI_REGS:
+        return si_reg(address) == SI_STATUS_REG;
+    default:
+        break;
+    }
+
+    /* cartridge ROM and PIF RAM */
+    return (address >= MM_CART_ROM && address < MM_PIF_MEM)
+        || (address >= MM_PIF_MEM + PIF_ROM_SIZE && address < MM_PIF_MEM + PIF_ROM_SIZE + PIF_RAM_SIZE);
+}
+
+int polling_loop_can_skip(struct r4300_core* r4300, uint32_t pc, uint32_t target)
+{
+    const struct device* dev = container_of(r4300, struct device, r4300);
+    const int64_t* regs = r4300_regs(r4300);
+    uint32_t address;
+    uint32_t iw;
+
+    if (target == pc) {
+        return 1;
+    }
+
+    /* base registers are inputs of the loop or were computed earlier
+     * in this iteration, and polling_loop_detect made sure they aren't
+     * written after their loads, so they hold the addresses the loop
+     * loads from */
+    for (address = target; address <= pc + 4; address += 4)
+    {
+        iw = *fast_mem_access(r4300, address);
+
+        if (is_load(iw))
+        {
+            uint32_t vaddr = (uint32_t)regs[RS_OF(iw)] + (uint32_t)(int16_t)iw;
+
+            if (!is_unmapped(vaddr) || !is_polled_address(dev, vaddr & UINT32_C(0x1fffffff))) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
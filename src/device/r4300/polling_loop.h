@@ -0,0 +1,64 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - polling_loop.h                                          *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DEVICE_R4300_POLLING_LOOP_H
+#define M64P_DEVICE_R4300_POLLING_LOOP_H
+
+#include <stdint.h>
+
+struct r4300_core;
+
+/* A polling loop is a short backward branch whose body only loads from
+ * memory and computes a condition from the loaded values, e.g.
+ *
+ *   loop: lw   t0, 0x10(a0)
+ *         andi t0, t0, 3
+ *         bnez t0, loop
+ *         nop
+ *
+ * Every register the loop reads is either loop-invariant or written earlier
+ * in the same iteration, so as long as the memory it polls doesn't change,
+ * each iteration does exactly the same thing. Such loops are handled like
+ * jumps to self: when the branch is taken, the count skips ahead to the next
+ * interrupt event.
+ *
+ * This is done by the pure and cached interpreters and by the old dynarec,
+ * when the SkipPollingLoops option is set. The new dynarec only skips jumps
+ * to self. */
+
+enum { POLLING_LOOP_MAX_LENGTH = 16 };
+
+/* Checks the instruction words of the loop from target to the delay slot
+ * of the branch at pc. Only loops in unmapped (kseg0/kseg1) memory are
+ * considered, so that reading them never raises a TLB exception.
+ * Always false when polling loops are not skipped. */
+int polling_loop_detect(struct r4300_core* r4300, uint32_t pc, uint32_t target);
+
+/* Checks, when the branch at pc is taken, that every address the loop
+ * loads from only changes on an interrupt event (RDRAM, cartridge, PIF RAM
+ * or a status register), which excludes counters such as VI_CURRENT_REG.
+ * RDRAM is assumed to be written only by the CPU and by DMAs, which end
+ * with an interrupt event. An RSP task running on the RSP worker thread
+ * can write it at any time, so RDRAM polls aren't skipped while one is
+ * pending. Always true for jumps to self. */
+int polling_loop_can_skip(struct r4300_core* r4300, uint32_t pc, uint32_t target);
+
+#endif /* M64P_DEVICE_R4300_POLLING_LOOP_H */
@@ -29,6 +29,7 @@
 #include "api/callbacks.h"
 #include "api/debugger.h"
 #include "api/m64p_types.h"
+#include "device/r4300/polling_loop.h"
 #include "device/r4300/r4300_core.h"
 #include "osal/preproc.h"
 
@@ -38,33 +39,6 @@
 #include "debugger/python_hooks.h"
 
 
-#include "device/memory/memory.h"
-#include "device/rdram/rdram.h"
-#include <stdio.h>
-#define FN_FLUSH 0x80139D70
-#define FN_MEMCPY 0x801D211C
-#define EMULATED_STDOUT 0x8025d578
-static uint32_t stdout_dst[256];
-static void debug_trigger_link(struct r4300_core* r4300, const uint32_t target) {
-
-	if (target == FN_FLUSH) {
-      if (getenv("GLOVER_STDOUT") != NULL) {
-         const uint32_t *src = mem_base_u32(r4300->mem->base, EMULATED_STDOUT & UINT32_C(0x1ffffffc));
-
-         for (int idx = 0; idx < 255; idx++) {
-            uint32_t word = htobe32(src[idx]);
-            stdout_dst[idx] = word;
-            if ((word & 0xFF) == 0 || (word & 0xFF00) == 0 ||
-               (word & 0xFF0000) == 0 || (word & 0xFF000000) == 0) {
-                  break;
-            }
-            printf("printf |%s\n", (const char *) stdout_dst);
-            fflush(stdout);
-         }
-      }
-	}
-}
-
 static void InterpretOpcode(struct r4300_core* r4300);
 
 #define DECLARE_R4300
@@ -102,9 +76,9 @@ static void InterpretOpcode(struct r4300_core* r4300);
       r4300->cp0.last_addr = r4300->interp_PC.addr; \
       if (*r4300_cp0_cycle_count(&r4300->cp0) >= 0) gen_interrupt(r4300); \
       \
-      if (link_register != &r4300_regs(r4300)[0]) \
+      if (link_register != &r4300_regs(r4300)[0] && call_hooks_match(&r4300->hooks.call_hooks, jump_target)) \
       { \
-          debug_trigger_link(r4300, jump_target); \
+          run_call_hooks(r4300, jump_target); \
       } \
    } \
    static void name##_IDLE(struct r4300_core* r4300, uint32_t op) \
@@ -112,8 +86,9 @@ static void InterpretOpcode(struct r4300_core* r4300);
       uint32_t* cp0_regs = r4300_cp0_regs(&r4300->cp0); \
       int* cp0_cycle_count = r4300_cp0_cycle_count(&r4300->cp0); \
       const int take_jump = (condition); \
+      const uint32_t jump_target = (destination); \
       if (cop1 && check_cop1_unusable(r4300)) return; \
-      if (take_jump) \
+      if (take_jump && polling_loop_can_skip(r4300, r4300->interp_PC.addr, jump_target)) \
       { \
          cp0_update_count(r4300); \
          if(*cp0_cycle_count < 0) \
@@ -137,11 +112,14 @@ static void InterpretOpcode(struct r4300_core* r4300);
 #define JUMP_OF(op)    ((op) & UINT32_C(0x3FFFFFF))
 
 /* Determines whether a relative jump in a 16-bit immediate goes back to the
- * same instruction without doing any work in its delay slot. The jump is
- * relative to the instruction in the delay slot, so 1 instruction backwards
- * (-1) goes back to the jump. */
+ * same instruction without doing any work in its delay slot, or goes back
+ * to the start of a polling loop. The jump is relative to the instruction
+ * in the delay slot, so 1 instruction backwards (-1) goes back to the jump. */
 #define IS_RELATIVE_IDLE_LOOP(r4300, op, addr) \
-	(IMM16S_OF(op) == -1 && *fast_mem_access((r4300), (addr) + 4) == 0)
+	((IMM16S_OF(op) == -1) \
+	 ? *fast_mem_access((r4300), (addr) + 4) == 0 \
+	 : (IMM16S_OF(op) < -1 && IMM16S_OF(op) >= -POLLING_LOOP_MAX_LENGTH \
+	    && polling_loop_detect((r4300), (addr), (addr) + (IMM16S_OF(op) + 1) * 4)))
 
 /* Determines whether an absolute jump in a 26-bit immediate goes back to the
  * same instruction without doing any work in its delay slot. The jump is
@@ -743,44 +721,12 @@ void InterpretOpcode(struct r4300_core* r4300)
 }
 
 
-uint32_t read_u32(struct r4300_core* r4300, uint32_t address) {
-   uint32_t alignment = address & 3;
-   if (alignment == 0) {
-      uint32_t value;
-      r4300_read_aligned_word(r4300, address, &value, "debug");
-      return value;
-   } else {
-      uint32_t address_left = address & 0xFFFFFFFC;
-      uint32_t address_right = address_left + 4;
-      uint32_t value_left;
-      uint32_t value_right;
-      r4300_read_aligned_word(r4300, address_left, &value_left, "debug");
-      r4300_read_aligned_word(r4300, address_right, &value_right, "debug");
-      return (value_left << (alignment * 8)) |
-             (value_right >> (32 - alignment * 8));
-   }
-}
-
-uint16_t read_u16(struct r4300_core* r4300, uint32_t address) {
-   return (read_u32(r4300, address) & 0xFFFF0000) >> 16;
-}
-
-uint8_t read_u8(struct r4300_core* r4300, uint32_t address) {
-   return (read_u32(r4300, address) & 0xFF000000) >> 24;
-}
-
-char cart_dma_read_trigger = 0;
-char cart_dma_write_trigger = 0;
-uint32_t cart_dma_dram;
-uint32_t cart_dma_base;
-uint32_t cart_dma_len;
-
-void run_pure_interpreter(struct r4300_core* r4300)
+/* The interpreter loop is instantiated with and without the python hook
+ * machinery, so that sessions without hooks don't pay for it.
+ * Hooks can only be registered from hook scripts and callbacks, so the
+ * loop without hooks never has to look for new ones. */
+static osal_inline void RunInterpreterLoop(struct r4300_core* r4300, const int with_hooks)
 {
-   *r4300_stop(r4300) = 0;
-   *r4300_pc_struct(r4300) = &r4300->interp_PC;
-   *r4300_pc(r4300) = r4300->cp0.last_addr = r4300->start_address;
-
    while (!*r4300_stop(r4300))
    {
 #ifdef COMPARE_CORE
@@ -791,57 +737,58 @@ void run_pure_interpreter(struct r4300_core* r4300)
 #endif
      InterpretOpcode(r4300);
 
-     pyRunPCHooks(r4300);
-     if (g_run_button_hooks == 1) {
+     if (!with_hooks)
+        continue;
+
+     if (r4300->hooks.active & R4300_HOOK_PC) {
+         pyRunPCHooks(r4300);
+     }
+     if (r4300->hooks.run_button_hooks) {
          pyRunButtonHooks(r4300);
-         g_run_button_hooks = 0;
+         r4300->hooks.run_button_hooks = 0;
      }
-     if (cart_dma_read_trigger) {
-         cart_dma_read_trigger = 0;
+     if (r4300->hooks.cart_dma_read_pending) {
+         r4300->hooks.cart_dma_read_pending = 0;
          // DMA write -> cartridge read
-         pyRunCartWriteHooks(r4300, cart_dma_base, cart_dma_len, cart_dma_dram);
+         pyRunCartWriteHooks(r4300, r4300->hooks.cart_dma_base, r4300->hooks.cart_dma_len, r4300->hooks.cart_dma_dram);
      }
-     if (cart_dma_write_trigger) {
-         cart_dma_write_trigger = 0;
+     if (r4300->hooks.cart_dma_write_pending) {
+         r4300->hooks.cart_dma_write_pending = 0;
          // DMA read -> cartridge write
-         pyRunCartReadHooks(r4300, cart_dma_base, cart_dma_len, cart_dma_dram);
+         pyRunCartReadHooks(r4300, r4300->hooks.cart_dma_base, r4300->hooks.cart_dma_len, r4300->hooks.cart_dma_dram);
      }
 
-      // Custom breakpoints
-
-      if (*r4300_pc(r4300) == 0x801822CC) {
-         // Top of landscape parsing hot loop
-
-
-         if (getenv("GLOVER_DUMP_LEV_OFFSETS") != NULL) {
-            // Get base address of buffer
-            uint32_t base_addr = read_u32(r4300, r4300->regs[29] + 0x3c);
-
-            // Get active level ID
-            uint32_t level_id = read_u8(r4300, 0x801e7531);
-
-            printf("level %d cmd +0x%x = 0x%04x\n", level_id, r4300->regs[2] - base_addr - 2, r4300->regs[4] >> 16);
-         }
-
-      }
-
-      if (*r4300_pc(r4300) == 0x80182eac) {
-         // Bottom of landscape parsing function
-         if (getenv("GLOVER_DUMP_LEV_OFFSETS") != NULL) {
-            printf("level parsing complete\n");
-            fflush(stdout);
-         }
-      }
+     /* the last hook has been removed */
+     if (!r4300->hooks.active) {
+         r4300->hooks.run_button_hooks = 0;
+         r4300->hooks.cart_dma_read_pending = 0;
+         r4300->hooks.cart_dma_write_pending = 0;
+         return;
+     }
+   }
+}
 
-      if (*r4300_pc(r4300) == 0x8011D88C) {
-         // Top of level loading machinery
+static void RunInterpreterWithHooks(struct r4300_core* r4300)
+{
+   RunInterpreterLoop(r4300, 1);
+}
 
-         // Force level load to levelID
-         if (getenv("GLOVER_LEVEL_ID") != NULL) {
-            r4300->regs[4] = atoi(getenv("GLOVER_LEVEL_ID"));
-         }
+static void RunInterpreterWithoutHooks(struct r4300_core* r4300)
+{
+   RunInterpreterLoop(r4300, 0);
+}
 
-      }
+void run_pure_interpreter(struct r4300_core* r4300)
+{
+   *r4300_stop(r4300) = 0;
+   *r4300_pc_struct(r4300) = &r4300->interp_PC;
+   *r4300_pc(r4300) = r4300->cp0.last_addr = r4300->start_address;
 
+   while (!*r4300_stop(r4300))
+   {
+     if (r4300->hooks.active)
+        RunInterpreterWithHooks(r4300);
+     else
+        RunInterpreterWithoutHooks(r4300);
    }
 }
@@ -47,7 +47,7 @@
 void dump_regs(struct r4300_core* r4300, const char *filename) {
     char filepath[512];
     char jsonblob[512];
-    sprintf(filepath, "%s/%s", ConfigGetParamString(g_CoreConfig, "RamDumpPath"), filename);
+    sprintf(filepath, "%s/%s", g_RamDumpPath.string, filename);
 
     FILE *f = fopen(filepath, "w");
 
@@ -65,7 +65,7 @@ void dump_regs(struct r4300_core* r4300, const char *filename) {
 }
 
 void init_r4300(struct r4300_core* r4300, struct memory* mem, struct mi_controller* mi, struct rdram* rdram, const struct interrupt_handler* interrupt_handlers,
-    unsigned int emumode, unsigned int count_per_op, int no_compiled_jump, int randomize_interrupt, uint32_t start_address)
+    unsigned int emumode, unsigned int count_per_op, int no_compiled_jump, int randomize_interrupt, int skip_polling_loops, uint32_t start_address)
 {
     struct new_dynarec_hot_state* new_dynarec_hot_state =
 #ifdef NEW_DYNAREC
@@ -86,7 +86,17 @@ void init_r4300(struct r4300_core* r4300, struct memory* mem, struct mi_controll
     r4300->mi = mi;
     r4300->rdram = rdram;
     r4300->randomize_interrupt = randomize_interrupt;
+    r4300->skip_polling_loops = skip_polling_loops;
     r4300->start_address = start_address;
+
+    /* hook tables are owned by the python layer (see pyLoadHooks) */
+    void* hook_tables = r4300->hooks.tables;
+    unsigned int active_hooks = r4300->hooks.active;
+    call_hooks_clear(&r4300->hooks.call_hooks);
+    memset(&r4300->hooks, 0, sizeof(r4300->hooks));
+    r4300->hooks.tables = hook_tables;
+    r4300->hooks.active = active_hooks;
+
     srand((unsigned int) time(NULL));
 }
 
@@ -143,6 +153,11 @@ void poweron_r4300(struct r4300_core* r4300)
     poweron_cp1(&r4300->cp1);
 }
 
+void release_r4300(struct r4300_core* r4300)
+{
+    release_tlb(&r4300->cp0.tlb);
+}
+
 
 void run_r4300(struct r4300_core* r4300)
 {
@@ -302,6 +317,16 @@ unsigned int get_r4300_emumode(struct r4300_core* r4300)
     return r4300->emumode;
 }
 
+/* Called when hooks.ram_pages changed */
+void r4300_ram_hooks_changed(struct r4300_core* r4300)
+{
+#ifdef NEW_DYNAREC
+    if (r4300->emumode == EMUMODE_DYNAREC) {
+        new_dynarec_update_ram_hooks();
+    }
+#endif
+}
+
 uint32_t *fast_mem_access(struct r4300_core* r4300, uint32_t address)
 {
     /* This code is performance critical, specially on pure interpreter mode.
@@ -319,9 +344,25 @@ uint32_t *fast_mem_access(struct r4300_core* r4300, uint32_t address)
 }
 
 
-uint32_t addr_log_min = 0;
-uint32_t addr_log_max = 0;
-uint32_t last_dump_base_addr = 0;
+/* Plain RDRAM is accessed directly instead of through its memory handler.
+ * Framebuffer protection, memory breakpoints and corrupted RDRAM reads
+ * all install handlers of their own, so those pages still go through
+ * the handler table.
+ */
+static osal_inline uint32_t* fast_rdram_read_word(const struct r4300_core* r4300, uint32_t address)
+{
+    return (mem_get_handler(r4300->mem, address)->read32 == read_rdram_dram)
+        ? &r4300->rdram->dram[rdram_dram_address(address)]
+        : NULL;
+}
+
+static osal_inline uint32_t* fast_rdram_write_word(const struct r4300_core* r4300, uint32_t address)
+{
+    return (mem_get_handler(r4300->mem, address)->write32 == write_rdram_dram)
+        ? &r4300->rdram->dram[rdram_dram_address(address)]
+        : NULL;
+}
+
 /* Read aligned word from memory.
  * address may not be word-aligned for byte or hword accesses.
  * Alignment is taken care of when calling mem handler.
@@ -329,6 +370,8 @@ uint32_t last_dump_base_addr = 0;
 
 int _untracked_r4300_read_aligned_word(struct r4300_core* r4300, uint32_t address, uint32_t* value, const char *instr_name)
 {
+    const uint32_t* word;
+
     if ((address & UINT32_C(0xc0000000)) != UINT32_C(0x80000000)) {
         address = virtual_to_physical_address(r4300, address, 0);
         if (address == 0) {
@@ -338,6 +381,11 @@ int _untracked_r4300_read_aligned_word(struct r4300_core* r4300, uint32_t addres
 
     address &= UINT32_C(0x1ffffffc);
 
+    if ((word = fast_rdram_read_word(r4300, address)) != NULL) {
+        *value = *word;
+        return 1;
+    }
+
     mem_read32(mem_get_handler(r4300->mem, address), address & ~UINT32_C(3), value);
 
     return 1;
@@ -347,25 +395,29 @@ int _untracked_r4300_read_aligned_word(struct r4300_core* r4300, uint32_t addres
 int r4300_read_aligned_word(struct r4300_core* r4300, uint32_t address, uint32_t* value, const char *instr_name)
 {
 
-    if (address >= addr_log_min && address < addr_log_max) {
+    struct r4300_hooks* hooks = &r4300->hooks;
+
+    if (address >= hooks->dump_log_min && address < hooks->dump_log_max) {
         // TODO: - it might be more useful to just collect a set() of 
         //         pc's that access the hot memory. from logs it looks like they 
         //         almost ALWAYS just move through memory linearly and don't jump around
         //         (like, fair enough)
         //       - dump frame pointer and other regs so we can do a stack trace
-        // printf("RDRAM ACCESS: PC[%08X] %4s %08X + %04X\n", (*r4300_pc(r4300)) - 4, instr_name, addr_log_min, unaligned_addr - addr_log_min);
-        if (last_dump_base_addr != addr_log_min) {
-            last_dump_base_addr = addr_log_min;
+        // printf("RDRAM ACCESS: PC[%08X] %4s %08X + %04X\n", (*r4300_pc(r4300)) - 4, instr_name, hooks->dump_log_min, unaligned_addr - hooks->dump_log_min);
+        if (hooks->last_dump_base_addr != hooks->dump_log_min) {
+            hooks->last_dump_base_addr = hooks->dump_log_min;
             char fname[32];
-            sprintf(fname, "dma.0x%08X.rdram.bin", last_dump_base_addr);
+            sprintf(fname, "dma.0x%08X.rdram.bin", hooks->last_dump_base_addr);
             dump_rdram(r4300->rdram, fname);
-            sprintf(fname, "dma.0x%08X.regs.yaml", last_dump_base_addr);
+            sprintf(fname, "dma.0x%08X.regs.yaml", hooks->last_dump_base_addr);
             dump_regs(r4300, fname);
 
         }
     }
 
-    pyRunRamReadHooks(r4300, address);
+    if (r4300->hooks.active & R4300_HOOK_RAM_READ) {
+        pyRunRamReadHooks(r4300, address);
+    }
     
     return _untracked_r4300_read_aligned_word(r4300, address, value, instr_name);
 }
@@ -373,9 +425,12 @@ int r4300_read_aligned_word(struct r4300_core* r4300, uint32_t address, uint32_t
 /* Read aligned dword from memory */
 int r4300_read_aligned_dword(struct r4300_core* r4300, uint32_t address, uint64_t* value)
 {
+    const uint32_t* word;
     uint32_t w[2];
 
-    pyRunRamReadHooks(r4300, address);
+    if (r4300->hooks.active & R4300_HOOK_RAM_READ) {
+        pyRunRamReadHooks(r4300, address);
+    }
 
     /* XXX: unaligned dword accesses should trigger a address error,
      * but inaccurate timing of the core can lead to unaligned address on reset
@@ -393,6 +448,11 @@ int r4300_read_aligned_dword(struct r4300_core* r4300, uint32_t address, uint64_
 
     address &= UINT32_C(0x1ffffffc);
 
+    if ((word = fast_rdram_read_word(r4300, address)) != NULL) {
+        *value = ((uint64_t)word[0] << 32) | word[1];
+        return 1;
+    }
+
     const struct mem_handler* handler = mem_get_handler(r4300->mem, address);
     mem_read32(handler, address + 0, &w[0]);
     mem_read32(handler, address + 4, &w[1]);
@@ -409,6 +469,8 @@ int r4300_read_aligned_dword(struct r4300_core* r4300, uint32_t address, uint64_
 
 int _untracked_r4300_write_aligned_word(struct r4300_core* r4300, uint32_t address, uint32_t value, uint32_t mask)
 {
+    uint32_t* word;
+
     if ((address & UINT32_C(0xc0000000)) != UINT32_C(0x80000000)) {
 
         invalidate_r4300_cached_code(r4300, address, 4);
@@ -423,6 +485,11 @@ int _untracked_r4300_write_aligned_word(struct r4300_core* r4300, uint32_t addre
 
     address &= UINT32_C(0x1ffffffc);
 
+    if ((word = fast_rdram_write_word(r4300, address)) != NULL) {
+        masked_write(word, value, mask);
+        return 1;
+    }
+
     mem_write32(mem_get_handler(r4300->mem, address), address & ~UINT32_C(3), value, mask);
 
     return 1;
@@ -431,10 +498,12 @@ int _untracked_r4300_write_aligned_word(struct r4300_core* r4300, uint32_t addre
 
 int r4300_write_aligned_word(struct r4300_core* r4300, uint32_t address, uint32_t value, uint32_t mask)
 {
-    pyRunRamWriteHooks(r4300, address, value, mask);
+    if (r4300->hooks.active & R4300_HOOK_RAM_WRITE) {
+        pyRunRamWriteHooks(r4300, address, value, mask);
+    }
 
-    if (address == ConfigGetParamInt(g_CoreConfig, "RamDumpTrigger")) {
-        // printf("trigger dump %08X / %08X\n", ConfigGetParamInt(g_CoreConfig, "RamDumpTrigger"), address);
+    if (address == g_RamDumpTrigger.integer) {
+        // printf("trigger dump %08X / %08X\n", g_RamDumpTrigger.integer, address);
         char fname[32];
         sprintf(fname, "trigger.0x%08X.rdram.bin", address);
         dump_rdram(r4300->rdram, fname);
@@ -448,7 +517,11 @@ int r4300_write_aligned_word(struct r4300_core* r4300, uint32_t address, uint32_
 /* Write aligned dword to memory */
 int r4300_write_aligned_dword(struct r4300_core* r4300, uint32_t address, uint64_t value, uint64_t mask)
 {
-    pyRunRamWriteHooks(r4300, address, value, mask);
+    uint32_t* word;
+
+    if (r4300->hooks.active & R4300_HOOK_RAM_WRITE) {
+        pyRunRamWriteHooks(r4300, address, value, mask);
+    }
 
     /* XXX: unaligned dword accesses should trigger a address error,
      * but inaccurate timing of the core can lead to unaligned address on reset
@@ -470,8 +543,8 @@ int r4300_write_aligned_dword(struct r4300_core* r4300, uint32_t address, uint64
     invalidate_r4300_cached_code(r4300, address, 8);
 
     address &= UINT32_C(0x1ffffffc);
-    if (address == ConfigGetParamInt(g_CoreConfig, "RamDumpTrigger")) {
-        printf("trigger dump (dword) %08X / %08X\n", ConfigGetParamInt(g_CoreConfig, "RamDumpTrigger"), address);
+    if (address == g_RamDumpTrigger.integer) {
+        printf("trigger dump (dword) %08X / %08X\n", g_RamDumpTrigger.integer, address);
         char fname[32];
         sprintf(fname, "trigger.0x%08X.rdram.bin", address);
         dump_rdram(r4300->rdram, fname);
@@ -479,6 +552,12 @@ int r4300_write_aligned_dword(struct r4300_core* r4300, uint32_t address, uint64
         dump_regs(r4300, fname);
     }
 
+    if ((word = fast_rdram_write_word(r4300, address)) != NULL) {
+        masked_write(&word[0], value >> 32,      mask >> 32);
+        masked_write(&word[1], (uint32_t) value, (uint32_t) mask      );
+        return 1;
+    }
+
     const struct mem_handler* handler = mem_get_handler(r4300->mem, address);
     mem_write32(handler, address + 0, value >> 32,      mask >> 32);
     mem_write32(handler, address + 4, (uint32_t) value, (uint32_t) mask      );
@@ -29,6 +29,7 @@
 #include <stdio.h>
 #endif
 
+#include "call_hooks.h"
 #include "cp0.h"
 #include "cp1.h"
 
@@ -43,10 +44,13 @@ struct mi_controller;
 struct rdram;
 
 struct jump_table;
+struct block_arena_chunk;
 struct cached_interp
 {
     char invalid_code[0x100000];
-    struct precomp_block* blocks[0x100000];
+    /* one block pointer per page, allocated zero-filled by init_blocks
+     * so that the pages of the table which are never used cost nothing */
+    struct precomp_block** blocks;
     struct precomp_block* actual;
 
     void (*fin_block)(void);
@@ -58,6 +62,72 @@ struct cached_interp
 
     void (*recompile_block)(struct r4300_core* r4300,
         const uint32_t* source, struct precomp_block* block, uint32_t func);
+
+    /* one bit per page which may hold compiled instructions,
+     * pages without any are skipped by code invalidation */
+    uint32_t code_pages[0x100000 / 32];
+    /* number of times each RDRAM page had its code invalidated,
+     * by any of the recompilers */
+    uint32_t invalidations[0x800];
+
+    /* storage of the blocks, see cached_interp_alloc */
+    struct block_arena_chunk* arena;
+};
+
+/* Kinds of python hooks, see r4300_hooks.active */
+enum r4300_hook_kind
+{
+    R4300_HOOK_PC         = 0x01,
+    R4300_HOOK_BUTTON     = 0x02,
+    R4300_HOOK_RAM_READ   = 0x04,
+    R4300_HOOK_RAM_WRITE  = 0x08,
+    R4300_HOOK_CART_READ  = 0x10,
+    R4300_HOOK_CART_WRITE = 0x20,
+};
+
+/* Per-instance state of the python hook layer.
+ * Devices post notifications here, the interpreter loop consumes them.
+ *
+ * Keeping it per core lets hook registration follow the core it belongs
+ * to; it doesn't make the core multi-instance. The following are still
+ * process-wide, so a process runs a single emulated machine at a time:
+ * - g_dev, g_mem_base and the other main.c statics (speed limiter, frame
+ *   counters, savestate requests, pacing, render skip, the bound g_RamDump*
+ *   config parameters),
+ * - ROM globals: ROM_HEADER, ROM_SETTINGS, ROM_PARAMS and the rom database,
+ * - plugin bindings (gfx, audio, input, rsp) and the RSP worker thread,
+ * - the perf map and fork server state,
+ * - the new dynarec globals (its code cache, hash tables and register
+ *   allocator state). */
+struct r4300_hooks
+{
+    /* hook tables, owned by the python hook layer */
+    void* tables;
+
+    /* R4300_HOOK_* kinds which have registered hooks, kept up to date by the
+     * python hook layer. Nothing is posted nor run for the other kinds. */
+    unsigned int active;
+
+    /* R4300_HOOK_RAM_* kinds hooked in each 4KB page of RDRAM (as seen
+     * through KSEG0), so that the dynarec only routes these pages to its
+     * slow path. Also kept up to date by the python hook layer. */
+    uint8_t ram_pages[0x800];
+
+    /* native actions on linking jumps */
+    struct call_hooks call_hooks;
+
+    int run_button_hooks;
+
+    int cart_dma_read_pending;
+    int cart_dma_write_pending;
+    uint32_t cart_dma_dram;
+    uint32_t cart_dma_base;
+    uint32_t cart_dma_len;
+
+    /* RDRAM range written by the last large cart DMA, dumped on first read */
+    uint32_t dump_log_min;
+    uint32_t dump_log_max;
+    uint32_t last_dump_base_addr;
 };
 
 enum {
@@ -195,8 +265,11 @@ struct r4300_core
     struct rdram* rdram;
 
     uint32_t randomize_interrupt;
+    uint32_t skip_polling_loops; /* see polling_loop.h */
 
     uint32_t start_address;
+
+    struct r4300_hooks hooks;
 };
 
 #define R4300_KSEG0 UINT32_C(0x80000000)
@@ -211,8 +284,9 @@ struct r4300_core
     offsetof(struct new_dynarec_hot_state, regs))
 #endif
 
-void init_r4300(struct r4300_core* r4300, struct memory* mem, struct mi_controller* mi, struct rdram* rdram, const struct interrupt_handler* interrupt_handlers, unsigned int emumode, unsigned int count_per_op, int no_compiled_jump, int randomize_interrupt, uint32_t start_address);
+void init_r4300(struct r4300_core* r4300, struct memory* mem, struct mi_controller* mi, struct rdram* rdram, const struct interrupt_handler* interrupt_handlers, unsigned int emumode, unsigned int count_per_op, int no_compiled_jump, int randomize_interrupt, int skip_polling_loops, uint32_t start_address);
 void poweron_r4300(struct r4300_core* r4300);
+void release_r4300(struct r4300_core* r4300);
 
 void run_r4300(struct r4300_core* r4300);
 
@@ -226,6 +300,8 @@ int* r4300_stop(struct r4300_core* r4300);
 
 unsigned int get_r4300_emumode(struct r4300_core* r4300);
 
+void r4300_ram_hooks_changed(struct r4300_core* r4300);
+
 /* Returns a pointer to a block of contiguous memory
  * Can access RDRAM, SP_DMEM, SP_IMEM and ROM, using TLB if necessary
  * Useful for getting fast access to a zone with executable code. */
@@ -43,6 +43,7 @@
 #include "device/r4300/recomp_types.h"
 #include "device/r4300/tlb.h"
 #include "main/main.h"
+#include "main/perf_map.h"
 #if defined(PROFILE)
 #include "main/profile.h"
 #endif
@@ -459,13 +460,13 @@ void dynarec_init_block(struct r4300_core* r4300, uint32_t address)
 
     /* allocate block */
     if (*block == NULL) {
-        *block = malloc(sizeof(struct precomp_block));
-        (*block)->block = NULL;
+        *block = cached_interp_alloc(&r4300->cached_interp, sizeof(struct precomp_block));
+        if (*block == NULL) {
+            DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate memory for dynamic recompiler.");
+            return;
+        }
         (*block)->start = address & ~UINT32_C(0xfff);
         (*block)->end = (address & ~UINT32_C(0xfff)) + 0x1000;
-        (*block)->code = NULL;
-        (*block)->jumps_table = NULL;
-        (*block)->riprel_table = NULL;
     }
 
     struct precomp_block* b = *block;
@@ -565,6 +566,9 @@ void dynarec_init_block(struct r4300_core* r4300, uint32_t address)
         }
     }
 
+    /* no compiled instruction left in the page */
+    clear_code_page(&r4300->cached_interp, b->start);
+
     free_all_registers(r4300);
     /* calling pass2 of the assembler is not necessary here because all of the code emitted by
        gennotcompiled() and gendebug() is position-independent and contains no jumps . */
@@ -633,6 +637,8 @@ void dynarec_recompile_block(struct r4300_core* r4300, const uint32_t* iw, struc
     /* reset xxhash */
     block->xxhash = 0;
 
+    set_code_page(&r4300->cached_interp, block->start);
+
     r4300->recomp.dst_block = block;
     r4300->recomp.code_length = block->code_length;
     r4300->recomp.max_code_length = block->max_code_length;
@@ -658,6 +664,7 @@ void dynarec_recompile_block(struct r4300_core* r4300, const uint32_t* iw, struc
             uint32_t address2 = virtual_to_physical_address(r4300, r4300->recomp.dst->addr, 0);
             if (r4300->cached_interp.blocks[address2>>12]->block[(address2&UINT32_C(0xFFF))/4].ops == r4300->cached_interp.not_compiled) {
                 r4300->cached_interp.blocks[address2>>12]->block[(address2&UINT32_C(0xFFF))/4].ops = r4300->cached_interp.not_compiled2;
+                set_code_page(&r4300->cached_interp, address2);
             }
         }
 
@@ -745,6 +752,9 @@ void dynarec_recompile_block(struct r4300_core* r4300, const uint32_t* iw, struc
     block->max_code_length = r4300->recomp.max_code_length;
     free_assembler(r4300, &block->jumps_table, &block->jumps_number, &block->riprel_table, &block->riprel_number);
 
+    perf_map_add(block->code + block->block[(func & 0xFFF) / 4].local_addr,
+                 block->code_length - block->block[(func & 0xFFF) / 4].local_addr, func);
+
 #ifdef DBG
     DebugMessage(M64MSG_INFO, "block recompiled (%" PRIX32 "-%" PRIX32 ")", func, block->start+i*4);
 #endif
@@ -21,24 +21,88 @@
 
 #include "tlb.h"
 
+#include "api/callbacks.h"
 #include "api/m64p_types.h"
 #include "device/r4300/r4300_core.h"
 #include "device/rdram/rdram.h"
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
+int tlb_lut_fill(struct tlb_lut* lut, uint32_t page, uint32_t count, uint32_t value, uint32_t step)
+{
+    uint32_t** chunk;
+    uint32_t i, j, n;
+
+    for (; count > 0; count -= n, page += n, value += n * step)
+    {
+        chunk = &lut->chunks[page >> TLB_LUT_CHUNK_SHIFT];
+        i = page & (TLB_LUT_CHUNK_PAGES - 1);
+        n = TLB_LUT_CHUNK_PAGES - i;
+        if (n > count)
+            n = count;
+
+        if (*chunk == NULL)
+        {
+            /* unmapping pages of an unallocated chunk is a no-op */
+            if (value == 0 && step == 0)
+                continue;
+
+            *chunk = calloc(TLB_LUT_CHUNK_PAGES, sizeof(**chunk));
+            if (*chunk == NULL)
+            {
+                DebugMessage(M64MSG_ERROR, "Memory error: couldn't allocate TLB lookup table.");
+                return -1;
+            }
+        }
+
+        for (j = 0; j < n; ++j)
+            (*chunk)[i + j] = value + j * step;
+    }
+
+    return 0;
+}
+
+int tlb_lut_set(struct tlb_lut* lut, uint32_t page, uint32_t value)
+{
+    return tlb_lut_fill(lut, page, 1, value, 0);
+}
+
+void tlb_lut_clear(struct tlb_lut* lut)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(lut->chunks) / sizeof(lut->chunks[0]); ++i)
+    {
+        free(lut->chunks[i]);
+        lut->chunks[i] = NULL;
+    }
+}
+
 void poweron_tlb(struct tlb* tlb)
 {
     /* clear TLB entries */
     memset(tlb->entries, 0, 32 * sizeof(tlb->entries[0]));
-    memset(tlb->LUT_r, 0, 0x100000 * sizeof(tlb->LUT_r[0]));
-    memset(tlb->LUT_w, 0, 0x100000 * sizeof(tlb->LUT_w[0]));
+    tlb_lut_clear(&tlb->LUT_r);
+    tlb_lut_clear(&tlb->LUT_w);
+}
+
+void release_tlb(struct tlb* tlb)
+{
+    /* free the lookup table chunks */
+    tlb_lut_clear(&tlb->LUT_r);
+    tlb_lut_clear(&tlb->LUT_w);
+}
+
+/* Number of pages from start to end, the last byte of a mapping */
+static uint32_t tlb_pages(uint32_t start, uint32_t end)
+{
+    return (start < end) ? ((end - start) >> 12) + 1 : 0;
 }
 
 void tlb_unmap(struct tlb* tlb, size_t entry)
 {
-    unsigned int i;
     const struct tlb_entry* e;
 
     assert(entry < 32);
@@ -46,27 +110,23 @@ void tlb_unmap(struct tlb* tlb, size_t entry)
 
     if (e->v_even)
     {
-        for (i=e->start_even; i<e->end_even; i += 0x1000)
-            tlb->LUT_r[i>>12] = 0;
+        tlb_lut_fill(&tlb->LUT_r, e->start_even >> 12, tlb_pages(e->start_even, e->end_even), 0, 0);
         if (e->d_even)
-            for (i=e->start_even; i<e->end_even; i += 0x1000)
-                tlb->LUT_w[i>>12] = 0;
+            tlb_lut_fill(&tlb->LUT_w, e->start_even >> 12, tlb_pages(e->start_even, e->end_even), 0, 0);
     }
 
     if (e->v_odd)
     {
-        for (i=e->start_odd; i<e->end_odd; i += 0x1000)
-            tlb->LUT_r[i>>12] = 0;
+        tlb_lut_fill(&tlb->LUT_r, e->start_odd >> 12, tlb_pages(e->start_odd, e->end_odd), 0, 0);
         if (e->d_odd)
-            for (i=e->start_odd; i<e->end_odd; i += 0x1000)
-                tlb->LUT_w[i>>12] = 0;
+            tlb_lut_fill(&tlb->LUT_w, e->start_odd >> 12, tlb_pages(e->start_odd, e->end_odd), 0, 0);
     }
 }
 
-void tlb_map(struct tlb* tlb, size_t entry)
+int tlb_map(struct tlb* tlb, size_t entry)
 {
-    unsigned int i;
     const struct tlb_entry* e;
+    int failed = 0;
 
     assert(entry < 32);
     e = &tlb->entries[entry];
@@ -77,11 +137,11 @@ void tlb_map(struct tlb* tlb, size_t entry)
             !(e->start_even >= 0x80000000 && e->end_even < 0xC0000000) &&
             e->phys_even < 0x20000000)
         {
-            for (i=e->start_even;i<e->end_even;i+=0x1000)
-                tlb->LUT_r[i>>12] = UINT32_C(0x80000000) | (e->phys_even + (i - e->start_even) + 0xFFF);
+            failed |= tlb_lut_fill(&tlb->LUT_r, e->start_even >> 12, tlb_pages(e->start_even, e->end_even),
+                                   UINT32_C(0x80000000) | (e->phys_even + 0xFFF), 0x1000);
             if (e->d_even)
-                for (i=e->start_even;i<e->end_even;i+=0x1000)
-                    tlb->LUT_w[i>>12] = UINT32_C(0x80000000) | (e->phys_even + (i - e->start_even) + 0xFFF);
+                failed |= tlb_lut_fill(&tlb->LUT_w, e->start_even >> 12, tlb_pages(e->start_even, e->end_even),
+                                       UINT32_C(0x80000000) | (e->phys_even + 0xFFF), 0x1000);
         }
     }
 
@@ -91,13 +151,15 @@ void tlb_map(struct tlb* tlb, size_t entry)
             !(e->start_odd >= 0x80000000 && e->end_odd < 0xC0000000) &&
             e->phys_odd < 0x20000000)
         {
-            for (i=e->start_odd;i<e->end_odd;i+=0x1000)
-                tlb->LUT_r[i>>12] = UINT32_C(0x80000000) | (e->phys_odd + (i - e->start_odd) + 0xFFF);
+            failed |= tlb_lut_fill(&tlb->LUT_r, e->start_odd >> 12, tlb_pages(e->start_odd, e->end_odd),
+                                   UINT32_C(0x80000000) | (e->phys_odd + 0xFFF), 0x1000);
             if (e->d_odd)
-                for (i=e->start_odd;i<e->end_odd;i+=0x1000)
-                    tlb->LUT_w[i>>12] = UINT32_C(0x80000000) | (e->phys_odd + (i - e->start_odd) + 0xFFF);
+                failed |= tlb_lut_fill(&tlb->LUT_w, e->start_odd >> 12, tlb_pages(e->start_odd, e->end_odd),
+                                       UINT32_C(0x80000000) | (e->phys_odd + 0xFFF), 0x1000);
         }
     }
+
+    return failed;
 }
 
 uint32_t virtual_to_physical_address(struct r4300_core* r4300, uint32_t address, int w)
@@ -109,16 +171,16 @@ uint32_t virtual_to_physical_address(struct r4300_core* r4300, uint32_t address,
     if (r4300->emumode == EMUMODE_DYNAREC)
     {
         intptr_t map = r4300->new_dynarec_hot_state.memory_map[addr];
-        if ((tlb->LUT_w[addr]) && (w == 1))
+        if ((tlb_lut_get(&tlb->LUT_w, addr)) && (w == 1))
         {
-            assert(map == (((uintptr_t)r4300->rdram->dram + (uintptr_t)((tlb->LUT_w[addr] & 0xFFFFF000) - 0x80000000) - (address & 0xFFFFF000)) >> 2));
+            assert(map == (((uintptr_t)r4300->rdram->dram + (uintptr_t)((tlb_lut_get(&tlb->LUT_w, addr) & 0xFFFFF000) - 0x80000000) - (address & 0xFFFFF000)) >> 2));
         }
-        else if ((tlb->LUT_r[addr]) && (w == 0))
+        else if ((tlb_lut_get(&tlb->LUT_r, addr)) && (w == 0))
         {
-            assert((map&~WRITE_PROTECT) == (((uintptr_t)r4300->rdram->dram + (uintptr_t)((tlb->LUT_r[addr] & 0xFFFFF000) - 0x80000000) - (address & 0xFFFFF000)) >> 2));
+            assert((map&~WRITE_PROTECT) == (((uintptr_t)r4300->rdram->dram + (uintptr_t)((tlb_lut_get(&tlb->LUT_r, addr) & 0xFFFFF000) - 0x80000000) - (address & 0xFFFFF000)) >> 2));
             if (map & WRITE_PROTECT)
             {
-                assert(tlb->LUT_w[addr] == 0);
+                assert(tlb_lut_get(&tlb->LUT_w, addr) == 0);
             }
         }
         else {
@@ -127,16 +189,10 @@ uint32_t virtual_to_physical_address(struct r4300_core* r4300, uint32_t address,
     }
 #endif
 
-    if (w == 1)
-    {
-        if (tlb->LUT_w[addr])
-            return (tlb->LUT_w[addr] & UINT32_C(0xFFFFF000)) | (address & UINT32_C(0xFFF));
-    }
-    else
-    {
-        if (tlb->LUT_r[addr])
-            return (tlb->LUT_r[addr] & UINT32_C(0xFFFFF000)) | (address & UINT32_C(0xFFF));
-    }
+    uint32_t phys = tlb_lut_get((w == 1) ? &tlb->LUT_w : &tlb->LUT_r, addr);
+    if (phys)
+        return (phys & UINT32_C(0xFFFFF000)) | (address & UINT32_C(0xFFF));
+
     //printf("tlb exception !!! @ %x, %x, add:%x\n", address, w, r4300->pc->addr);
     //getchar();
 
@@ -25,6 +25,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "osal/preproc.h"
+
 struct r4300_core;
 
 struct tlb_entry
@@ -52,17 +54,43 @@ struct tlb_entry
    unsigned int phys_odd;
 };
 
+/* Virtual page to physical address lookup table.
+ * It is split in chunks covering 16MB of virtual address space, which are
+ * only allocated once a TLB entry maps a page in them. Unallocated chunks
+ * read as unmapped. */
+enum { TLB_LUT_CHUNK_SHIFT = 12 };
+enum { TLB_LUT_CHUNK_PAGES = 1 << TLB_LUT_CHUNK_SHIFT };
+
+struct tlb_lut
+{
+    uint32_t* chunks[0x100000 >> TLB_LUT_CHUNK_SHIFT];
+};
+
 struct tlb
 {
     struct tlb_entry entries[32];
-    uint32_t LUT_r[0x100000];
-    uint32_t LUT_w[0x100000];
+    struct tlb_lut LUT_r;
+    struct tlb_lut LUT_w;
 };
 
+static osal_inline uint32_t tlb_lut_get(const struct tlb_lut* lut, uint32_t page)
+{
+    const uint32_t* chunk = lut->chunks[page >> TLB_LUT_CHUNK_SHIFT];
+    return (chunk != NULL) ? chunk[page & (TLB_LUT_CHUNK_PAGES - 1)] : 0;
+}
+
+/* Set count consecutive pages starting at page, to value, value + step, ...
+ * Returns zero on success, nonzero if a chunk couldn't be allocated. */
+int tlb_lut_fill(struct tlb_lut* lut, uint32_t page, uint32_t count, uint32_t value, uint32_t step);
+int tlb_lut_set(struct tlb_lut* lut, uint32_t page, uint32_t value);
+void tlb_lut_clear(struct tlb_lut* lut);
+
 void poweron_tlb(struct tlb* tlb);
+void release_tlb(struct tlb* tlb);
 
 void tlb_unmap(struct tlb* tlb, size_t entry);
-void tlb_map(struct tlb* tlb, size_t entry);
+/* Returns zero on success, nonzero if the lookup tables couldn't be updated */
+int tlb_map(struct tlb* tlb, size_t entry);
 
 uint32_t virtual_to_physical_address(struct r4300_core* r4300, uint32_t address, int w);
 
@@ -2169,6 +2169,8 @@ static void gentest_out(struct r4300_core* r4300)
     jmp(r4300->recomp.dst->addr + 4);
 }
 
+/* Only used for jumps to self: idle branches closing a polling loop call
+ * their interpreter version instead, which checks the polled addresses. */
 static void gentest_idle(struct r4300_core* r4300)
 {
     int reg;
@@ -2680,7 +2682,8 @@ void gen_BEQ_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BEQ_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BEQ_IDLE, 1);
         return;
@@ -2734,7 +2737,8 @@ void gen_BEQL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BEQL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BEQL_IDLE, 1);
         return;
@@ -2857,7 +2861,8 @@ void gen_BNE_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BNE_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BNE_IDLE, 1);
         return;
@@ -2911,7 +2916,8 @@ void gen_BNEL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BNEL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BNEL_IDLE, 1);
         return;
@@ -3006,7 +3012,8 @@ void gen_BLEZ_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BLEZ_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BLEZ_IDLE, 1);
         return;
@@ -3060,7 +3067,8 @@ void gen_BLEZL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BLEZL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BLEZL_IDLE, 1);
         return;
@@ -3155,7 +3163,8 @@ void gen_BGTZ_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BGTZ_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BGTZ_IDLE, 1);
         return;
@@ -3209,7 +3218,8 @@ void gen_BGTZL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BGTZL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BGTZL_IDLE, 1);
         return;
@@ -3297,7 +3307,8 @@ void gen_BLTZ_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BLTZ_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BLTZ_IDLE, 1);
         return;
@@ -3408,7 +3419,8 @@ void gen_BLTZL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BLTZL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BLTZL_IDLE, 1);
         return;
@@ -3553,7 +3565,8 @@ void gen_BGEZ_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BGEZ_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BGEZ_IDLE, 1);
         return;
@@ -3664,7 +3677,8 @@ void gen_BGEZL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned int)cached_interp_BGEZL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned int)cached_interp_BGEZL_IDLE, 1);
         return;
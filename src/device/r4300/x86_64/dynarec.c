@@ -2322,6 +2322,8 @@ static void gentest_out(struct r4300_core* r4300)
     jmp(r4300->recomp.dst->addr + 4);
 }
 
+/* Only used for jumps to self: idle branches closing a polling loop call
+ * their interpreter version instead, which checks the polled addresses. */
 static void gentest_idle(struct r4300_core* r4300)
 {
     int reg;
@@ -2827,7 +2829,8 @@ void gen_BEQ_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BEQ_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BEQ_IDLE, 1);
         return;
@@ -2887,7 +2890,8 @@ void gen_BEQL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BEQL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BEQL_IDLE, 1);
         return;
@@ -2984,7 +2988,8 @@ void gen_BNE_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BNE_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BNE_IDLE, 1);
         return;
@@ -3044,7 +3049,8 @@ void gen_BNEL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BNEL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BNEL_IDLE, 1);
         return;
@@ -3124,7 +3130,8 @@ void gen_BLEZ_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BLEZ_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BLEZ_IDLE, 1);
         return;
@@ -3184,7 +3191,8 @@ void gen_BLEZL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BLEZL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BLEZL_IDLE, 1);
         return;
@@ -3264,7 +3272,8 @@ void gen_BGTZ_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BGTZ_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BGTZ_IDLE, 1);
         return;
@@ -3324,7 +3333,8 @@ void gen_BGTZL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BGTZL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BGTZL_IDLE, 1);
         return;
@@ -3409,7 +3419,8 @@ void gen_BLTZ_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BLTZ_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BLTZ_IDLE, 1);
         return;
@@ -3532,7 +3543,8 @@ void gen_BLTZL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BLTZL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BLTZL_IDLE, 1);
         return;
@@ -3678,7 +3690,8 @@ void gen_BGEZ_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BGEZ_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BGEZ_IDLE, 1);
         return;
@@ -3801,7 +3814,8 @@ void gen_BGEZL_IDLE(struct r4300_core* r4300)
     gencallinterp(r4300, (unsigned long long)cached_interp_BGEZL_IDLE, 1);
 #else
     if (((r4300->recomp.dst->addr & 0xFFF) == 0xFFC && (r4300->recomp.dst->addr < 0x80000000 || r4300->recomp.dst->addr >= 0xC0000000))
-       || r4300->recomp.no_compiled_jump)
+       || r4300->recomp.no_compiled_jump
+       || r4300->recomp.dst->f.i.immediate != -1)
     {
         gencallinterp(r4300, (unsigned long long)cached_interp_BGEZL_IDLE, 1);
         return;
@@ -86,6 +86,8 @@ void read_dpc_regs(void* opaque, uint32_t address, uint32_t* value)
     struct rdp_core* dp = (struct rdp_core*)opaque;
     uint32_t reg = dpc_reg(address);
 
+    rsp_task_sync(dp->sp);
+
     *value = dp->dpc_regs[reg];
 }
 
@@ -94,6 +96,8 @@ void write_dpc_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mas
     struct rdp_core* dp = (struct rdp_core*)opaque;
     uint32_t reg = dpc_reg(address);
 
+    rsp_task_sync(dp->sp);
+
     switch(reg)
     {
     case DPC_STATUS_REG:
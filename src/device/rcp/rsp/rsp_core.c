@@ -30,6 +30,7 @@
 #include "device/rcp/ri/ri_controller.h"
 #include "device/rdram/rdram.h"
 #include "main/main.h"
+#include "main/rsp_worker.h"
 #if defined(PROFILE)
 #include "main/profile.h"
 #endif
@@ -216,12 +217,21 @@ void init_rsp(struct rsp_core* sp,
 
 void poweron_rsp(struct rsp_core* sp)
 {
+    if (sp->task_pending)
+    {
+        rsp_worker_wait_task();
+        sp->task_pending = 0;
+    }
+
     memset(sp->mem, 0, SP_MEM_SIZE);
     memset(sp->regs, 0, SP_REGS_COUNT*sizeof(uint32_t));
     memset(sp->regs2, 0, SP_REGS2_COUNT*sizeof(uint32_t));
     memset(sp->fifo, 0, SP_DMA_FIFO_SIZE*sizeof(struct sp_dma));
 
     sp->rsp_task_locked = 0;
+    sp->mi_intr = 0;
+    sp->mi_intr_start = 0;
+    sp->gfx_task_skipped = 0;
     sp->mi->r4300->cp0.interrupt_unsafe_state &= ~INTR_UNSAFE_RSP;
     sp->regs[SP_STATUS_REG] = 1;
 }
@@ -232,6 +242,8 @@ void read_rsp_mem(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t addr = rsp_mem_address(address);
 
+    rsp_task_sync(sp);
+
     *value = sp->mem[addr];
 }
 
@@ -240,6 +252,8 @@ void write_rsp_mem(void* opaque, uint32_t address, uint32_t value, uint32_t mask
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t addr = rsp_mem_address(address);
 
+    rsp_task_sync(sp);
+
     masked_write(&sp->mem[addr], value, mask);
 }
 
@@ -249,6 +263,8 @@ void read_rsp_regs(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg(address);
 
+    rsp_task_sync(sp);
+
     *value = sp->regs[reg];
 
     if (reg == SP_SEMAPHORE_REG)
@@ -262,6 +278,8 @@ void write_rsp_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mas
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg(address);
 
+    rsp_task_sync(sp);
+
     switch(reg)
     {
     case SP_STATUS_REG:
@@ -293,6 +311,8 @@ void read_rsp_regs2(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg2(address);
 
+    rsp_task_sync(sp);
+
     *value = sp->regs2[reg];
 }
 
@@ -301,21 +321,145 @@ void write_rsp_regs2(void* opaque, uint32_t address, uint32_t value, uint32_t ma
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg2(address);
 
+    rsp_task_sync(sp);
+
     masked_write(&sp->regs2[reg], value, mask);
 }
 
+/* Hands a copy of MI_INTR_REG to the RSP plugin for the next task */
+static void start_task_interrupts(struct rsp_core* sp)
+{
+    sp->mi_intr = sp->mi->regs[MI_INTR_REG];
+    sp->mi_intr_start = sp->mi_intr;
+}
+
+/* Applies the MI_INTR_REG bits set and cleared by the RSP plugin to the MI,
+ * keeping the bits changed meanwhile by the emulation thread */
+static void merge_task_interrupts(struct rsp_core* sp)
+{
+    uint32_t set = sp->mi_intr & ~sp->mi_intr_start;
+    uint32_t cleared = sp->mi_intr_start & ~sp->mi_intr;
+
+    sp->mi->regs[MI_INTR_REG] = (sp->mi->regs[MI_INTR_REG] | set) & ~cleared;
+}
+
+/* Common end of task handling.
+ * Returns non-zero if the task is to be followed by an SP interrupt. */
+static int end_sp_task(struct rsp_core* sp)
+{
+    int sp_int = 0;
+
+    sp->rsp_task_locked = 0;
+    sp->mi->r4300->cp0.interrupt_unsafe_state &= ~INTR_UNSAFE_RSP;
+    if ((sp->regs[SP_STATUS_REG] & (SP_STATUS_HALT | SP_STATUS_BROKE)) == 0)
+    {
+        sp->rsp_task_locked = 1;
+        sp->mi->r4300->cp0.interrupt_unsafe_state |= INTR_UNSAFE_RSP;
+        sp->mi->regs[MI_INTR_REG] |= MI_INTR_SP;
+    }
+    if (sp->mi->regs[MI_INTR_REG] & MI_INTR_SP)
+    {
+        sp_int = 1;
+        sp->mi->regs[MI_INTR_REG] &= ~MI_INTR_SP;
+    }
+
+    sp->regs[SP_STATUS_REG] &=
+        ~(SP_STATUS_TASKDONE | SP_STATUS_BROKE | SP_STATUS_HALT);
+
+    return sp_int;
+}
+
+/* Waits for the task in flight on the RSP worker and ends it */
+static int finish_sp_task(struct rsp_core* sp)
+{
+    rsp_worker_wait_task();
+    sp->task_pending = 0;
+
+    sp->regs2[SP_PC_REG] |= sp->task_save_pc;
+    merge_task_interrupts(sp);
+
+    return end_sp_task(sp);
+}
+
+void complete_sp_task(struct rsp_core* sp)
+{
+    /* The SP interrupt of an asynchronous task is scheduled when the task
+     * starts, at the time it would have been with a synchronous one. */
+    if (!finish_sp_task(sp))
+    {
+        cp0_update_count(sp->mi->r4300);
+        cancel_interrupt_event(&sp->mi->r4300->cp0, SP_INT);
+    }
+}
+
+unsigned int skip_rsp_task(const uint32_t* dmem, uint32_t* sp_status, uint32_t* mi_intr)
+{
+    unsigned int ended = 0;
+
+    if (dmem[OSTASK_TYPE/4] == M_GFXTASK && (*sp_status & SP_STATUS_YIELD))
+    {
+        /* the microcode saves its state and breaks, the task isn't done */
+        *sp_status |= SP_STATUS_YIELDED | SP_STATUS_BROKE | SP_STATUS_HALT;
+        ended |= RSP_TASK_YIELDED;
+    }
+    else
+    {
+        *sp_status |= SP_STATUS_TASKDONE | SP_STATUS_BROKE | SP_STATUS_HALT;
+
+        /* the display list ends with a full sync, unless it doesn't use the RDP */
+        if (dmem[OSTASK_TYPE/4] == M_GFXTASK && !(dmem[OSTASK_FLAGS/4] & OS_TASK_SP_ONLY))
+            ended |= RSP_TASK_FULL_SYNC;
+    }
+
+    if (*sp_status & SP_STATUS_INTR_BREAK)
+        *mi_intr |= MI_INTR_SP;
+
+    return ended;
+}
+
+/* Whether to skip the graphics task in DMEM: a yielded task resumes the way
+ * it started, as only the video plugin has the state of one it ran */
+static int skip_gfx_task(struct rsp_core* sp)
+{
+    if (!(sp->mem[OSTASK_FLAGS/4] & OS_TASK_YIELDED))
+        sp->gfx_task_skipped = !main_render_frame();
+
+    return sp->gfx_task_skipped;
+}
+
 void do_SP_Task(struct rsp_core* sp)
 {
     uint32_t save_pc = sp->regs2[SP_PC_REG] & ~0xfff;
 
     uint32_t sp_delay_time;
 
-    if (sp->mem[0xfc0/4] == 1)
+    if (sp->mem[0xfc0/4] == 1 && skip_gfx_task(sp))
+    {
+        /* Skipped graphics task: end it the way the RSP and video plugins
+         * would, so that the SP and DP interrupts come at the usual time. */
+        unsigned int ended = skip_rsp_task(sp->mem, &sp->regs[SP_STATUS_REG], &sp->mi->regs[MI_INTR_REG]);
+
+        if (!(ended & RSP_TASK_YIELDED))
+            new_frame();
+
+        if (ended & RSP_TASK_FULL_SYNC)
+        {
+            if (sp->dp->dpc_regs[DPC_STATUS_REG] & DPC_STATUS_FREEZE) {
+                sp->dp->do_on_unfreeze |= DELAY_DP_INT;
+            } else {
+                cp0_update_count(sp->mi->r4300);
+                add_interrupt_event(&sp->mi->r4300->cp0, DP_INT, 4000);
+            }
+        }
+        sp_delay_time = 1000;
+    }
+    else if (sp->mem[0xfc0/4] == 1)
     {
         unprotect_framebuffers(&sp->dp->fb);
 
         //gfx.processDList();
         sp->regs2[SP_PC_REG] &= 0xfff;
+        start_task_interrupts(sp);
 #if defined(PROFILE)
         timed_section_start(TIMED_SECTION_GFX);
 #endif
@@ -324,6 +468,7 @@ void do_SP_Task(struct rsp_core* sp)
         timed_section_end(TIMED_SECTION_GFX);
 #endif
         sp->regs2[SP_PC_REG] |= save_pc;
+        merge_task_interrupts(sp);
         new_frame();
 
         if (sp->mi->regs[MI_INTR_REG] & MI_INTR_DP)
@@ -344,6 +489,27 @@ void do_SP_Task(struct rsp_core* sp)
     {
         //audio.processAList();
         sp->regs2[SP_PC_REG] &= 0xfff;
+        start_task_interrupts(sp);
+
+        /* Audio tasks can overlap with the CPU: their results are only
+         * looked at once the task is synced, either by its SP interrupt
+         * or by an earlier access to the RSP. Graphics tasks stay on the
+         * emulation thread, which owns the video plugin context. */
+        if (sp->async_tasks && get_event(&sp->mi->r4300->cp0.q, SP_INT) == NULL)
+        {
+            sp->task_save_pc = save_pc;
+            sp->task_pending = 1;
+
+            /* no savestate or reset while the task is in flight */
+            sp->mi->r4300->cp0.interrupt_unsafe_state |= INTR_UNSAFE_RSP;
+
+            cp0_update_count(sp->mi->r4300);
+            add_interrupt_event(&sp->mi->r4300->cp0, SP_INT, 4000);
+
+            rsp_worker_start_task();
+            return;
+        }
+
 #if defined(PROFILE)
         timed_section_start(TIMED_SECTION_AUDIO);
 #endif
@@ -352,41 +518,37 @@ void do_SP_Task(struct rsp_core* sp)
         timed_section_end(TIMED_SECTION_AUDIO);
 #endif
         sp->regs2[SP_PC_REG] |= save_pc;
+        merge_task_interrupts(sp);
 
         sp_delay_time = 4000;
     }
     else
     {
         sp->regs2[SP_PC_REG] &= 0xfff;
+        start_task_interrupts(sp);
         rsp.doRspCycles(0xffffffff);
         sp->regs2[SP_PC_REG] |= save_pc;
+        merge_task_interrupts(sp);
 
         sp_delay_time = 0;
     }
 
-    sp->rsp_task_locked = 0;
-    sp->mi->r4300->cp0.interrupt_unsafe_state &= ~INTR_UNSAFE_RSP;
-    if ((sp->regs[SP_STATUS_REG] & (SP_STATUS_HALT | SP_STATUS_BROKE)) == 0)
-    {
-        sp->rsp_task_locked = 1;
-        sp->mi->r4300->cp0.interrupt_unsafe_state |= INTR_UNSAFE_RSP;
-        sp->mi->regs[MI_INTR_REG] |= MI_INTR_SP;
-    }
-    if (sp->mi->regs[MI_INTR_REG] & MI_INTR_SP)
+    if (end_sp_task(sp))
     {
         cp0_update_count(sp->mi->r4300);
         add_interrupt_event(&sp->mi->r4300->cp0, SP_INT, sp_delay_time);
-        sp->mi->regs[MI_INTR_REG] &= ~MI_INTR_SP;
     }
-
-    sp->regs[SP_STATUS_REG] &=
-        ~(SP_STATUS_TASKDONE | SP_STATUS_BROKE | SP_STATUS_HALT);
 }
 
 void rsp_interrupt_event(void* opaque)
 {
     struct rsp_core* sp = (struct rsp_core*)opaque;
 
+    /* this is the interrupt scheduled for the task in flight:
+     * nothing more to do if that task turned out not to raise one */
+    if (sp->task_pending && !finish_sp_task(sp))
+        return;
+
     if (!sp->rsp_task_locked)
     {
         sp->regs[SP_STATUS_REG] |=
@@ -402,5 +564,6 @@ void rsp_interrupt_event(void* opaque)
 void rsp_end_of_dma_event(void* opaque)
 {
     struct rsp_core* sp = (struct rsp_core*)opaque;
+    rsp_task_sync(sp);
     fifo_pop(sp);
 }
@@ -55,6 +55,34 @@ enum
     SP_STATUS_SIG7       = 0x4000,
 };
 
+/* OSTask header, at the end of DMEM */
+enum
+{
+    OSTASK_TYPE  = 0xfc0,
+    OSTASK_FLAGS = 0xfc4
+};
+
+enum
+{
+    M_GFXTASK = 1,
+    M_AUDTASK = 2
+};
+
+enum
+{
+    OS_TASK_YIELDED = 0x0001,
+    OS_TASK_DP_WAIT = 0x0002,
+    OS_TASK_SP_ONLY = 0x0008
+};
+
+/* how skip_rsp_task ended a task */
+enum
+{
+    RSP_TASK_YIELDED   = 0x1,
+    /* the RDP got a full sync, which raises the DP interrupt */
+    RSP_TASK_FULL_SYNC = 0x2
+};
+
 enum sp_registers
 {
     SP_MEM_ADDR_REG,
@@ -98,6 +126,20 @@ struct rsp_core
     uint32_t regs2[SP_REGS2_COUNT];
     uint32_t rsp_task_locked;
 
+    /* copy of MI_INTR_REG handed to the RSP plugin while it runs a task,
+     * and its value when the task started */
+    uint32_t mi_intr;
+    uint32_t mi_intr_start;
+
+    /* audio tasks run on the RSP worker (see do_SP_Task) */
+    uint32_t async_tasks;
+    uint32_t task_pending;
+    uint32_t task_save_pc;
+
+    /* the last graphics task was skipped (see do_SP_Task), so is its
+     * continuation if it yielded */
+    uint32_t gfx_task_skipped;
+
     struct mi_controller* mi;
     struct rdp_core* dp;
     struct ri_controller* ri;
@@ -136,7 +178,22 @@ void write_rsp_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mas
 void read_rsp_regs2(void* opaque, uint32_t address, uint32_t* value);
 void write_rsp_regs2(void* opaque, uint32_t address, uint32_t value, uint32_t mask);
 
+/* Ends the task of dmem without running it, the way its microcode would:
+ * a graphics task yields if the CPU asked for it, any other task is done.
+ * Sets MI_INTR_SP in *mi_intr if the SP interrupts on break, and returns
+ * RSP_TASK_* flags. */
+unsigned int skip_rsp_task(const uint32_t* dmem, uint32_t* sp_status, uint32_t* mi_intr);
+
 void do_SP_Task(struct rsp_core* sp);
+void complete_sp_task(struct rsp_core* sp);
+
+/* Waits for the task in flight on the RSP worker, if any.
+ * Must be called before accessing the RSP state. */
+static osal_inline void rsp_task_sync(struct rsp_core* sp)
+{
+    if (sp->task_pending)
+        complete_sp_task(sp);
+}
 
 void rsp_interrupt_event(void* opaque);
 void rsp_end_of_dma_event(void* opaque);
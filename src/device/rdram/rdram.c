@@ -249,9 +249,9 @@ void write_rdram_dram(void* opaque, uint32_t address, uint32_t value, uint32_t m
 
 void dump_rdram(struct rdram* rdram, const char *filename) {
     char filepath[512];
-    size_t start = ConfigGetParamInt(g_CoreConfig, "RamDumpStart"); 
-    size_t end = ConfigGetParamInt(g_CoreConfig, "RamDumpEnd");
-    sprintf(filepath, "%s/%s", ConfigGetParamString(g_CoreConfig, "RamDumpPath"), filename);
+    size_t start = g_RamDumpStart.integer; 
+    size_t end = g_RamDumpEnd.integer;
+    sprintf(filepath, "%s/%s", g_RamDumpPath.string, filename);
 
     if (start < 0 || start >= rdram->dram_size) {
         return;
@@ -71,7 +71,6 @@
 #include "eventloop.h"
 #include "main.h"
 #include "plugin/plugin.h"
-#include "debugger/python_hooks.h"
 #include "sdl_key_converter.h"
 #include "util.h"
 
@@ -140,6 +139,14 @@ static const char *JoyCmdName[] = { "Joy Mapping Fullscreen",
 
 static const int NumJoyCommands = sizeof(JoyCmdName) / sizeof(const char *);
 
+/* keyboard mappings, bound so that a keypress doesn't walk the config list */
+static char l_SaveSlotKeyName[10][sizeof(kbdSaveSlot)+1];
+static config_param l_SaveSlotKey[10];
+static config_param l_KeyStop, l_KeyFullscreen, l_KeySave, l_KeyLoad, l_KeyIncrement,
+                    l_KeyReset, l_KeySpeeddown, l_KeySpeedup, l_KeyScreenshot, l_KeyRamDump,
+                    l_KeyPause, l_KeyMute, l_KeyIncrease, l_KeyDecrease, l_KeyForward,
+                    l_KeyAdvance, l_KeyGameshark;
+
 static int JoyCmdActive[16][2];  /* if extra joystick commands are added above, make sure there is enough room in this array */
                                  /* [i][0] is Command Active, [i][1] is Hotkey Active */
 
@@ -591,18 +598,38 @@ int event_set_core_defaults(void)
     ConfigSetDefaultString(l_CoreEventsConfig, JoyCmdName[joyAdvance], "",    "Joystick event string for advancing by one frame when paused");
     ConfigSetDefaultString(l_CoreEventsConfig, JoyCmdName[joyGameshark], "",  "Joystick event string for pressing the game shark button");
 
+    /* bind the keyboard mappings read on each keypress */
+    for (int slot = 0; slot < 10; slot++)
+    {
+        sprintf(l_SaveSlotKeyName[slot], "%s%i", kbdSaveSlot, slot);
+        ConfigBindParam(&l_SaveSlotKey[slot], "CoreEvents", l_SaveSlotKeyName[slot]);
+    }
+    ConfigBindParam(&l_KeyStop, "CoreEvents", kbdStop);
+    ConfigBindParam(&l_KeyFullscreen, "CoreEvents", kbdFullscreen);
+    ConfigBindParam(&l_KeySave, "CoreEvents", kbdSave);
+    ConfigBindParam(&l_KeyLoad, "CoreEvents", kbdLoad);
+    ConfigBindParam(&l_KeyIncrement, "CoreEvents", kbdIncrement);
+    ConfigBindParam(&l_KeyReset, "CoreEvents", kbdReset);
+    ConfigBindParam(&l_KeySpeeddown, "CoreEvents", kbdSpeeddown);
+    ConfigBindParam(&l_KeySpeedup, "CoreEvents", kbdSpeedup);
+    ConfigBindParam(&l_KeyScreenshot, "CoreEvents", kbdScreenshot);
+    ConfigBindParam(&l_KeyRamDump, "CoreEvents", kbdRamDump);
+    ConfigBindParam(&l_KeyPause, "CoreEvents", kbdPause);
+    ConfigBindParam(&l_KeyMute, "CoreEvents", kbdMute);
+    ConfigBindParam(&l_KeyIncrease, "CoreEvents", kbdIncrease);
+    ConfigBindParam(&l_KeyDecrease, "CoreEvents", kbdDecrease);
+    ConfigBindParam(&l_KeyForward, "CoreEvents", kbdForward);
+    ConfigBindParam(&l_KeyAdvance, "CoreEvents", kbdAdvance);
+    ConfigBindParam(&l_KeyGameshark, "CoreEvents", kbdGameshark);
+
     return 1;
 }
 
 static int get_saveslot_from_keysym(int keysym)
 {
-    char kbdSaveSlotStr[sizeof(kbdSaveSlot)+1];
-    int kbdSaveSlotKey;
     for (int slot = 0; slot < 10; slot++)
     {
-        sprintf(kbdSaveSlotStr, "%s%i", kbdSaveSlot, slot);
-        kbdSaveSlotKey = ConfigGetParamInt(l_CoreEventsConfig, kbdSaveSlotStr);
-        if (keysym == sdl_keysym2native(kbdSaveSlotKey))
+        if (keysym == sdl_keysym2native(l_SaveSlotKey[slot].integer))
             return slot;
     }
 
@@ -623,39 +650,39 @@ void event_sdl_keydown(int keysym, int keymod)
     /* check all of the configurable commands */
     else if ((slot = get_saveslot_from_keysym(keysym)) >= 0)
         main_state_set_slot(slot);
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdStop)))
+    else if (keysym == sdl_keysym2native(l_KeyStop.integer))
         main_stop();
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdFullscreen)))
+    else if (keysym == sdl_keysym2native(l_KeyFullscreen.integer))
         gfx.changeWindow();
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdSave)))
+    else if (keysym == sdl_keysym2native(l_KeySave.integer))
         main_state_save(0, NULL); /* save in mupen64plus format using current slot */
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdLoad)))
+    else if (keysym == sdl_keysym2native(l_KeyLoad.integer))
         main_state_load(NULL); /* load using current slot */
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdIncrement)))
+    else if (keysym == sdl_keysym2native(l_KeyIncrement.integer))
         main_state_inc_slot();
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdReset)))
+    else if (keysym == sdl_keysym2native(l_KeyReset.integer))
         main_reset(0);
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdSpeeddown)))
+    else if (keysym == sdl_keysym2native(l_KeySpeeddown.integer))
         main_speeddown(5);
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdSpeedup)))
+    else if (keysym == sdl_keysym2native(l_KeySpeedup.integer))
         main_speedup(5);
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdScreenshot)))
+    else if (keysym == sdl_keysym2native(l_KeyScreenshot.integer))
         main_take_next_screenshot();    /* screenshot will be taken at the end of frame rendering */
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdRamDump)))
+    else if (keysym == sdl_keysym2native(l_KeyRamDump.integer))
         main_rdram_dump();
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdPause)))
+    else if (keysym == sdl_keysym2native(l_KeyPause.integer))
         main_toggle_pause();
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdMute)))
+    else if (keysym == sdl_keysym2native(l_KeyMute.integer))
         main_volume_mute();
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdIncrease)))
+    else if (keysym == sdl_keysym2native(l_KeyIncrease.integer))
         main_volume_up();
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdDecrease)))
+    else if (keysym == sdl_keysym2native(l_KeyDecrease.integer))
         main_volume_down();
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdForward)))
+    else if (keysym == sdl_keysym2native(l_KeyForward.integer))
         main_set_fastforward(1);
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdAdvance)))
+    else if (keysym == sdl_keysym2native(l_KeyAdvance.integer))
         main_advance_one();
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdGameshark))) {
+    else if (keysym == sdl_keysym2native(l_KeyGameshark.integer)) {
         event_set_gameshark(1);
     }
     else
@@ -664,26 +691,30 @@ void event_sdl_keydown(int keysym, int keymod)
         input.keyDown(keymod, keysym);
     }
 
-    g_run_button_hooks = 1;
+    if (g_dev.r4300.hooks.active & R4300_HOOK_BUTTON) {
+        g_dev.r4300.hooks.run_button_hooks = 1;
+    }
 }
 
 void event_sdl_keyup(int keysym, int keymod)
 {
-    if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdStop)))
+    if (keysym == sdl_keysym2native(l_KeyStop.integer))
     {
         return;
     }
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdForward)))
+    else if (keysym == sdl_keysym2native(l_KeyForward.integer))
     {
         main_set_fastforward(0);
     }
-    else if (keysym == sdl_keysym2native(ConfigGetParamInt(l_CoreEventsConfig, kbdGameshark)))
+    else if (keysym == sdl_keysym2native(l_KeyGameshark.integer))
     {
         event_set_gameshark(0);
     }
     else input.keyUp(keymod, keysym);
 
-    g_run_button_hooks = 1;
+    if (g_dev.r4300.hooks.active & R4300_HOOK_BUTTON) {
+        g_dev.r4300.hooks.run_button_hooks = 1;
+    }
 }
 
 int event_gameshark_active(void)
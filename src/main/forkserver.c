@@ -0,0 +1,500 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - forkserver.c                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Job protocol (one job per connection, newline terminated):
+ *
+ *   RUN frames=<n> [state=<path>] [args=<rest of line>]
+ *       Fork a child from the snapshot, optionally load <path> in it, and
+ *       run it for <n> frames. The child answers "OK <job> <frames> <result>"
+ *       when it is done. If it dies, the server answers "ERR <job> <reason>".
+ *   QUIT
+ *       Wait for running jobs, then stop the server and the emulator.
+ */
+
+#include "forkserver.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define M64P_CORE_PROTOTYPES 1
+#include "api/callbacks.h"
+#include "api/m64p_config.h"
+#include "api/m64p_types.h"
+#include "debugger/python_hooks.h"
+#include "main/main.h"
+#include "main/perf_map.h"
+#include "plugin/plugin.h"
+#include "main/rsp_worker.h"
+#include "main/savestates.h"
+
+#define FORK_SERVER_LINE_MAX 4096
+#define FORK_SERVER_POLL_MS 100
+#define FORK_SERVER_REQUEST_TIMEOUT_MS 2000
+
+struct fork_server_child
+{
+    pid_t pid;
+    int conn;
+    unsigned int job_id;
+};
+
+static int l_enabled = 0;
+static int l_listen_fd = -1;
+static unsigned int l_start_frame = 0;
+static char l_socket_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+
+static struct fork_server_child* l_children = NULL;
+static size_t l_children_count = 0;
+static size_t l_children_max = 0;
+static unsigned int l_next_job_id = 0;
+
+/* child side */
+static int l_is_child = 0;
+static int l_conn = -1;
+static unsigned int l_job_id = 0;
+static unsigned int l_job_start_frame = 0;
+static unsigned int l_job_end_frame = 0;
+static char l_job_args[FORK_SERVER_LINE_MAX];
+static char l_job_result[FORK_SERVER_LINE_MAX];
+
+/*********************************************************************************************************
+* static functions
+*/
+
+static void send_line(int fd, const char* format, ...) ATTR_FMT(2, 3);
+
+static void send_line(int fd, const char* format, ...)
+{
+    char buffer[FORK_SERVER_LINE_MAX + 64];
+    va_list ap;
+    int len;
+    size_t sent = 0;
+
+    va_start(ap, format);
+    len = vsnprintf(buffer, sizeof(buffer) - 1, format, ap);
+    va_end(ap);
+
+    if (len < 0)
+        return;
+    if ((size_t)len > sizeof(buffer) - 2)
+        len = sizeof(buffer) - 2;
+    buffer[len++] = '\n';
+
+    while (sent < (size_t)len)
+    {
+        ssize_t n = send(fd, buffer + sent, len - sent, MSG_NOSIGNAL);
+        if (n <= 0 && errno != EINTR)
+            return;
+        if (n > 0)
+            sent += n;
+    }
+}
+
+static int read_line(int fd, char* line, size_t size)
+{
+    size_t len = 0;
+
+    while (len + 1 < size)
+    {
+        char c;
+        ssize_t n = recv(fd, &c, 1, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        if (c == '\n')
+            break;
+        if (c != '\r')
+            line[len++] = c;
+    }
+
+    line[len] = '\0';
+    return (int)len;
+}
+
+static int open_socket(const char* path)
+{
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        DebugMessage(M64MSG_ERROR, "Fork server: socket() failed: %s", strerror(errno));
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    /* remove a stale socket from a previous run */
+    unlink(addr.sun_path);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0
+     || listen(fd, 64) != 0)
+    {
+        DebugMessage(M64MSG_ERROR, "Fork server: can't listen on %s: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void remove_child(size_t i)
+{
+    close(l_children[i].conn);
+    l_children[i] = l_children[--l_children_count];
+}
+
+/* Reap finished jobs. Only our own job pids are waited on, so children
+ * spawned by the frontend or plugins are left alone. If block is set and
+ * no job has finished, sleep for one poll interval before returning. */
+static void reap_children(int block)
+{
+    int status;
+    int reaped = 0;
+    size_t i = 0;
+
+    while (i < l_children_count)
+    {
+        pid_t pid = waitpid(l_children[i].pid, &status, WNOHANG);
+
+        if (pid == 0 || (pid < 0 && errno == EINTR))
+        {
+            ++i;
+            continue;
+        }
+
+        /* a child which exits cleanly has already answered its job */
+        if (pid > 0 && WIFSIGNALED(status))
+            send_line(l_children[i].conn, "ERR %u killed by signal %d", l_children[i].job_id, WTERMSIG(status));
+        else if (pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) != 0)
+            send_line(l_children[i].conn, "ERR %u exited with status %d", l_children[i].job_id, WEXITSTATUS(status));
+        else if (pid < 0)
+            send_line(l_children[i].conn, "ERR %u lost: %s", l_children[i].job_id, strerror(errno));
+
+        /* swaps the last entry into slot i, so don't advance */
+        remove_child(i);
+        reaped = 1;
+    }
+
+    if (block && !reaped)
+        poll(NULL, 0, FORK_SERVER_POLL_MS);
+}
+
+/* Parses "frames=<n> [state=<path>] [args=<rest of line>]".
+ * Returns 0 on success. */
+static int parse_run_request(char* params, unsigned int* frames, char** state, char** args)
+{
+    char* token = params;
+
+    *frames = 0;
+    *state = NULL;
+    *args = "";
+
+    while (token != NULL && *token != '\0')
+    {
+        char* next;
+
+        while (*token == ' ')
+            ++token;
+
+        /* args= consumes everything up to the end of line */
+        if (strncmp(token, "args=", 5) == 0)
+        {
+            *args = token + 5;
+            break;
+        }
+
+        next = strchr(token, ' ');
+        if (next != NULL)
+            *next++ = '\0';
+
+        if (strncmp(token, "frames=", 7) == 0)
+            *frames = (unsigned int)strtoul(token + 7, NULL, 10);
+        else if (strncmp(token, "state=", 6) == 0)
+            *state = token + 6;
+        else if (*token != '\0')
+            return -1;
+
+        token = next;
+    }
+
+    return (*frames == 0) ? -1 : 0;
+}
+
+/* Runs in the child right after fork. Returns to emulation. */
+static void start_job(int conn, unsigned int job_id, unsigned int frame, unsigned int frames, const char* state, const char* args)
+{
+    size_t i;
+
+    close(l_listen_fd);
+    l_listen_fd = -1;
+    for (i = 0; i < l_children_count; ++i)
+        close(l_children[i].conn);
+    free(l_children);
+    l_children = NULL;
+    l_children_count = 0;
+
+    l_is_child = 1;
+    l_conn = conn;
+    l_job_id = job_id;
+    l_job_start_frame = frame;
+    l_job_end_frame = frame + frames;
+    strncpy(l_job_args, args, sizeof(l_job_args) - 1);
+    l_job_result[0] = '\0';
+
+    rsp_worker_after_fork();
+    perf_map_after_fork();
+    pyAfterForkChild();
+
+    if (state != NULL && state[0] != '\0')
+        main_state_load(state);
+}
+
+static void finish_job(unsigned int frame)
+{
+    send_line(l_conn, "OK %u %u %s", l_job_id, frame - l_job_start_frame, l_job_result);
+    close(l_conn);
+
+    fflush(stdout);
+    fflush(stderr);
+
+    /* don't run atexit handlers or plugin teardown: they belong to the parent */
+    _exit(0);
+}
+
+/* Serve jobs until a child is forked (returns in the child)
+ * or QUIT is requested (returns in the parent). */
+static void serve(unsigned int frame)
+{
+    char line[FORK_SERVER_LINE_MAX];
+
+    l_listen_fd = open_socket(l_socket_path);
+    if (l_listen_fd < 0)
+    {
+        l_enabled = 0;
+        return;
+    }
+
+    DebugMessage(M64MSG_INFO, "Fork server: listening on %s at frame %u (%u jobs max)",
+        l_socket_path, frame, (unsigned int)l_children_max);
+
+    for (;;)
+    {
+        struct pollfd pfd;
+        struct timeval timeout;
+        int conn;
+
+        reap_children(l_children_count >= l_children_max);
+        if (l_children_count >= l_children_max)
+            continue;
+
+        pfd.fd = l_listen_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, FORK_SERVER_POLL_MS) <= 0)
+            continue;
+
+        conn = accept(l_listen_fd, NULL, NULL);
+        if (conn < 0)
+            continue;
+
+        /* don't let a silent client stall the server */
+        timeout.tv_sec = FORK_SERVER_REQUEST_TIMEOUT_MS / 1000;
+        timeout.tv_usec = (FORK_SERVER_REQUEST_TIMEOUT_MS % 1000) * 1000;
+        setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        if (read_line(conn, line, sizeof(line)) == 0)
+        {
+            send_line(conn, "ERR - no request received");
+            close(conn);
+            continue;
+        }
+
+        if (strncmp(line, "RUN ", 4) == 0)
+        {
+            unsigned int frames;
+            char* state;
+            char* args;
+            pid_t pid;
+
+            if (parse_run_request(line + 4, &frames, &state, &args) != 0)
+            {
+                send_line(conn, "ERR - invalid request");
+                close(conn);
+                continue;
+            }
+
+            /* avoid duplicating buffered output in the child */
+            fflush(stdout);
+            fflush(stderr);
+            perf_map_before_fork();
+
+            pyBeforeFork();
+            pid = fork();
+            if (pid != 0)
+                pyAfterForkParent();
+
+            if (pid == 0)
+            {
+                start_job(conn, l_next_job_id, frame, frames, state, args);
+                return;
+            }
+            else if (pid < 0)
+            {
+                send_line(conn, "ERR - fork failed: %s", strerror(errno));
+                close(conn);
+                continue;
+            }
+
+            l_children[l_children_count].pid = pid;
+            l_children[l_children_count].conn = conn;
+            l_children[l_children_count].job_id = l_next_job_id++;
+            ++l_children_count;
+        }
+        else if (strcmp(line, "QUIT") == 0)
+        {
+            while (l_children_count > 0)
+                reap_children(1);
+
+            send_line(conn, "OK");
+            close(conn);
+            break;
+        }
+        else
+        {
+            send_line(conn, "ERR - unknown command");
+            close(conn);
+        }
+    }
+
+    close(l_listen_fd);
+    l_listen_fd = -1;
+    unlink(l_socket_path);
+    l_enabled = 0;
+
+    DebugMessage(M64MSG_INFO, "Fork server: stopped.");
+    main_stop();
+}
+
+/*********************************************************************************************************
+* global functions
+*/
+
+void fork_server_init(void)
+{
+    const char* path = ConfigGetParamString(g_CoreConfig, "ForkServerSocket");
+    const char* state = ConfigGetParamString(g_CoreConfig, "ForkServerState");
+    int max_children = ConfigGetParamInt(g_CoreConfig, "ForkServerMaxJobs");
+
+    l_enabled = 0;
+    l_is_child = 0;
+
+    if (path == NULL || path[0] == '\0')
+        return;
+
+    if (strlen(path) >= sizeof(l_socket_path))
+    {
+        DebugMessage(M64MSG_ERROR, "Fork server: socket path too long: %s", path);
+        return;
+    }
+    strcpy(l_socket_path, path);
+
+    if (!plugin_is_headless())
+    {
+        DebugMessage(M64MSG_ERROR, "Fork server: needs the built-in headless plugins (HeadlessPlugins, no plugin attached)");
+        return;
+    }
+
+    if (max_children <= 0)
+        max_children = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_children <= 0)
+        max_children = 1;
+
+    free(l_children);
+    l_children = malloc(max_children * sizeof(*l_children));
+    if (l_children == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "Fork server: failed to allocate job table");
+        return;
+    }
+    l_children_count = 0;
+    l_children_max = (size_t)max_children;
+
+    l_start_frame = (unsigned int)ConfigGetParamInt(g_CoreConfig, "ForkServerFrame");
+    l_enabled = 1;
+
+    if (state != NULL && state[0] != '\0')
+        main_state_load(state);
+}
+
+void fork_server_new_frame(unsigned int frame)
+{
+    if (!l_enabled)
+        return;
+
+    if (l_is_child)
+    {
+        if (frame >= l_job_end_frame)
+            finish_job(frame);
+    }
+    /* wait for the snapshot savestate to be loaded before serving */
+    else if (frame >= l_start_frame && savestates_get_job() == savestates_job_nothing)
+    {
+        serve(frame);
+    }
+}
+
+void fork_server_shutdown(unsigned int frame)
+{
+    if (l_is_child)
+    {
+        /* emulation was stopped before the frame budget was exhausted */
+        finish_job(frame);
+    }
+
+    free(l_children);
+    l_children = NULL;
+    l_children_count = 0;
+    l_enabled = 0;
+}
+
+const char* fork_server_job_args(void)
+{
+    return l_job_args;
+}
+
+void fork_server_set_result(const char* result)
+{
+    strncpy(l_job_result, result, sizeof(l_job_result) - 1);
+    l_job_result[sizeof(l_job_result) - 1] = '\0';
+}
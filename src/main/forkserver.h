@@ -0,0 +1,75 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - forkserver.h                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef __FORKSERVER_H__
+#define __FORKSERVER_H__
+
+#include "osal/preproc.h"
+
+/* The fork server lets a booted core serve many short jobs.
+ *
+ * Once the configured frame is reached (and the optional savestate has been
+ * loaded), the emulation thread stops and listens on a local socket.
+ * Each job request forks a copy-on-write child which resumes emulation
+ * from the snapshot, runs for the requested number of frames and reports
+ * back on the job connection. The parent only serves jobs until it is
+ * asked to quit.
+ *
+ * fork() only duplicates the calling thread, so the children would lose any
+ * plugin, audio or video thread of the parent. The server therefore only
+ * starts with the built-in headless plugins (HeadlessPlugins, and no plugin
+ * attached by the front-end). The RSP worker is restarted in each child.
+ * Children aren't recycled: every job is a fresh fork of the snapshot. */
+
+#ifdef M64P_FORKSERVER
+
+void fork_server_init(void);
+void fork_server_new_frame(unsigned int frame);
+void fork_server_shutdown(unsigned int frame);
+const char* fork_server_job_args(void);
+void fork_server_set_result(const char* result);
+
+#else
+
+static osal_inline void fork_server_init(void)
+{
+}
+
+static osal_inline void fork_server_new_frame(unsigned int frame)
+{
+}
+
+static osal_inline void fork_server_shutdown(unsigned int frame)
+{
+}
+
+static osal_inline const char* fork_server_job_args(void)
+{
+    return "";
+}
+
+static osal_inline void fork_server_set_result(const char* result)
+{
+}
+
+#endif
+
+#endif
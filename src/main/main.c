@@ -64,15 +64,20 @@
 #include "device/gb/gb_cart.h"
 #include "device/pif/bootrom_hle.h"
 #include "eventloop.h"
+#include "forkserver.h"
+#include "perf_map.h"
 #include "main.h"
 #include "osal/files.h"
 #include "osal/preproc.h"
+#include "osal/timer.h"
 #include "osd/osd.h"
+#include "plugin/headless_input.h"
 #include "plugin/plugin.h"
 #if defined(PROFILE)
 #include "profile.h"
 #endif
 #include "rom.h"
+#include "rsp_worker.h"
 #include "savestates.h"
 #include "screenshot.h"
 #include "util.h"
@@ -93,6 +98,13 @@
 /** globals **/
 m64p_handle g_CoreConfig = NULL;
 
+/* core parameters read at runtime */
+config_param g_RamDumpPath;
+config_param g_RamDumpStart;
+config_param g_RamDumpEnd;
+config_param g_RamDumpTrigger;
+static config_param l_OnScreenDisplay;
+
 m64p_frame_callback g_FrameCallback = NULL;
 
 int         g_RomWordsLittleEndian = 0; // after loading, ROM words are in native N64 byte order (big endian). We will swap them on x86
@@ -123,6 +135,30 @@ static int   l_TakeScreenshot = 0;       // Tell OSD Rendering callback to take
 static int   l_SpeedFactor = 100;        // percentage of nominal game speed at which emulator is running
 static int   l_FrameAdvance = 0;         // variable to check if we pause on next frame
 static int   l_MainSpeedLimit = 1;       // insert delay during vi_interrupt to keep speed at real-time
+static int   l_RenderSkip = RENDER_SKIP_OFF; // which graphics tasks are skipped (see main_render_frame)
+static int   l_RenderSkipFrames = 0;     // frames skipped after a rendered one (fixed) or at most in a row (adaptive)
+static int   l_RenderSkipped = 0;        // frames skipped since the last rendered one
+static int   l_RenderNextFrame = 0;      // render the next frame whatever the render skip policy
+static int   l_RenderBehind = 0;         // emulation is running behind the target speed
+
+/* frame pacing (see apply_speed_limiter) */
+enum pacing_mode
+{
+    PACING_SPEED_FACTOR,
+    PACING_UNCAPPED,
+    PACING_FIXED_MULTIPLE
+};
+enum { PACING_SAMPLES = 1024 };
+#define PACING_MAX_LAG_NS 50000000
+
+static int     l_PacingMode = PACING_SPEED_FACTOR;
+static double  l_PacingMultiple = 1.0;
+static int64_t l_PacingPeriod = 0;       // duration of a VI at the current pace
+static int64_t l_PacingDeadline = 0;     // when the current VI is due, 0 to start over
+static int64_t l_PacingLastVI = 0;       // when the previous VI was done waiting
+static unsigned int l_PacingVIs = 0;     // number of VIs recorded in l_PacingSamples
+static m64p_pacing_sample l_PacingSamples[PACING_SAMPLES];
+static SDL_mutex* l_PacingLock = NULL;
 
 static osd_message_t *l_msgRamDump = NULL;
 static osd_message_t *l_msgVol = NULL;
@@ -292,7 +328,7 @@ void main_message(m64p_msg_level level, unsigned int corner, const char *format,
     va_end(ap);
 
     /* send message to on-screen-display if enabled */
-    if (ConfigGetParamBool(g_CoreConfig, "OnScreenDisplay"))
+    if (l_OnScreenDisplay.integer)
         osd_new_message((enum osd_corner) corner, "%s", buffer);
     /* send message to front-end */
     DebugMessage(level, "%s", buffer);
@@ -355,14 +391,30 @@ int main_set_core_defaults(void)
     ConfigSetDefaultString(g_CoreConfig, "SharedDataPath", "", "Path to a directory to search when looking for shared data files");
     ConfigSetDefaultString(g_CoreConfig, "RamDumpPath", "/tmp/", "Path to directory where ram dumps are saved.");
     ConfigSetDefaultString(g_CoreConfig, "PythonHookPath", "", "Path to directory where python debugger hooks are stored.");
+    ConfigSetDefaultString(g_CoreConfig, "CallHooks", "", "Native actions on guest calls, separated by ';': <target>:print@<addr> prints the guest string at addr, <target>:<reg>=<value> sets a register (e.g. 8011D88C:a0=3)");
     ConfigSetDefaultInt(g_CoreConfig, "RamDumpStart", 0, "Starting address of ram dump (inclusive)");
     ConfigSetDefaultInt(g_CoreConfig, "RamDumpEnd", -1, "Ending address of ram dump (inclusive). -1 for end of RAM.");
     ConfigSetDefaultInt(g_CoreConfig, "RamDumpTrigger", -1, "RDRAM write address to trigger ram dump");
     ConfigSetDefaultInt(g_CoreConfig, "CountPerOp", 0, "Force number of cycles per emulated instruction");
     ConfigSetDefaultBool(g_CoreConfig, "RandomizeInterrupt", 1, "Randomize PI/SI Interrupt Timing");
+    ConfigSetDefaultBool(g_CoreConfig, "SkipPollingLoops", 1, "Skip to the next interrupt in short loops polling memory, like in jumps to self. Interpreters and old dynarec only, the new dynarec only skips jumps to self");
     ConfigSetDefaultInt(g_CoreConfig, "SiDmaDuration", -1, "Duration of SI DMA (-1: use per game settings)");
     ConfigSetDefaultString(g_CoreConfig, "GbCameraVideoCaptureBackend1", DEFAULT_VIDEO_CAPTURE_BACKEND, "Gameboy Camera Video Capture backend");
     ConfigSetDefaultInt(g_CoreConfig, "SaveDiskFormat", 1, "Disk Save Format (0: Full Disk Copy (*.ndr/*.d6r), 1: RAM Area Only (*.ram))");
+    ConfigSetDefaultString(g_CoreConfig, "ForkServerSocket", "", "Path of the local socket on which to serve forked jobs. Empty to disable the fork server. Needs HeadlessPlugins, with no plugin attached");
+    ConfigSetDefaultInt(g_CoreConfig, "ForkServerFrame", 0, "Frame at which the fork server starts serving jobs");
+    ConfigSetDefaultString(g_CoreConfig, "ForkServerState", "", "Savestate to load before the fork server starts serving jobs");
+    ConfigSetDefaultInt(g_CoreConfig, "ForkServerMaxJobs", 0, "Maximum number of concurrent fork server jobs (0: number of CPUs)");
+    ConfigSetDefaultInt(g_CoreConfig, "DynarecCacheSize", 32, "Size in MB of the new dynarec translation cache (4, 8, 16 or 32)");
+    ConfigSetDefaultInt(g_CoreConfig, "LargePages", 1, "Back the emulated memory and the new dynarec translation cache with 2MB pages (0: off, 1: transparent huge pages, 2: reserved huge pages (hugetlbfs, or Windows large pages) falling back to 1)");
+    ConfigSetDefaultBool(g_CoreConfig, "HeadlessPlugins", 0, "Use the built-in headless plugins in place of the plugins not attached by the front-end: no video output, audio dropped, inputs queued from Python, and RSP tasks ended without being run");
+    ConfigSetDefaultInt(g_CoreConfig, "HeadlessControllers", 1, "Number of controllers plugged in by the headless input plugin");
+    ConfigSetDefaultInt(g_CoreConfig, "RenderSkip", RENDER_SKIP_OFF, "Graphics tasks to skip, keeping their interrupt timing (0: render every frame, 1: skip RenderSkipFrames frames after each rendered one, 2: skip up to RenderSkipFrames frames in a row while running behind the target speed, 3: never render)");
+    ConfigSetDefaultInt(g_CoreConfig, "RenderSkipFrames", 3, "Number of frames skipped by the fixed and adaptive render skip policies");
+    ConfigSetDefaultInt(g_CoreConfig, "PacingMode", PACING_SPEED_FACTOR, "Frame pacing when the speed limiter is on (0: real-time scaled by the speed factor, 1: uncapped, 2: real-time multiplied by PacingMultiple)");
+    ConfigSetDefaultFloat(g_CoreConfig, "PacingMultiple", 1.0, "Multiple of real-time speed used by the fixed multiple pacing mode");
+    ConfigSetDefaultBool(g_CoreConfig, "AsyncRsp", 0, "Run audio RSP tasks on a worker thread, overlapped with the CPU emulation (the RSP plugin must not forward audio lists to the audio plugin)");
+    ConfigSetDefaultString(g_CoreConfig, "PerfMapSymbols", "", "Symbol map (\"<hex address> <name>\" or \"<name> = 0x<address>;\" lines) used to name recompiled blocks in the perf map");
 
     /* handle upgrades */
     if (bUpgrade)
@@ -375,6 +427,13 @@ int main_set_core_defaults(void)
         }
     }
 
+    /* bind the parameters read at runtime */
+    ConfigBindParam(&g_RamDumpPath, "Core", "RamDumpPath");
+    ConfigBindParam(&g_RamDumpStart, "Core", "RamDumpStart");
+    ConfigBindParam(&g_RamDumpEnd, "Core", "RamDumpEnd");
+    ConfigBindParam(&g_RamDumpTrigger, "Core", "RamDumpTrigger");
+    ConfigBindParam(&l_OnScreenDisplay, "Core", "OnScreenDisplay");
+
     /* set config parameters for keyboard and joystick commands */
     return event_set_core_defaults();
 }
@@ -553,6 +612,46 @@ static void main_draw_volume_osd(void)
 void main_take_next_screenshot(void)
 {
     l_TakeScreenshot = l_CurrentFrame + 1;
+    main_render_next_frame();
+}
+
+void main_render_next_frame(void)
+{
+    l_RenderNextFrame = 1;
+}
+
+/* Tells whether the graphics task of the current frame is to be run,
+ * according to the render skip policy */
+int main_render_frame(void)
+{
+    int render;
+
+    if (l_RenderNextFrame)
+    {
+        l_RenderNextFrame = 0;
+        render = 1;
+    }
+    else
+    {
+        switch (l_RenderSkip)
+        {
+            case RENDER_SKIP_FIXED:
+                render = (l_RenderSkipped >= l_RenderSkipFrames);
+                break;
+            case RENDER_SKIP_ADAPTIVE:
+                render = (!l_RenderBehind || l_RenderSkipped >= l_RenderSkipFrames);
+                break;
+            case RENDER_SKIP_NEVER:
+                render = 0;
+                break;
+            default:
+                render = 1;
+                break;
+        }
+    }
+
+    l_RenderSkipped = render ? 0 : l_RenderSkipped + 1;
+    return render;
 }
 
 void main_state_set_slot(int slot)
@@ -826,7 +925,7 @@ m64p_error main_reset(int do_hard_reset)
 
 static void video_plugin_render_callback(int bScreenRedrawn)
 {
-    int bOSD = ConfigGetParamBool(g_CoreConfig, "OnScreenDisplay");
+    int bOSD = l_OnScreenDisplay.integer;
 
     // if the flag is set to take a screenshot, then grab it now
     if (l_TakeScreenshot != 0)
@@ -860,6 +959,9 @@ void new_frame(void)
 
     /* advance the current frame */
     l_CurrentFrame++;
+    headlessinput_new_frame();
+
+    fork_server_new_frame(l_CurrentFrame);
 
     if (l_FrameAdvance) {
         g_rom_pause = 1;
@@ -868,36 +970,18 @@ void new_frame(void)
     }
 }
 
-#define SAMPLE_COUNT 3
+/* Paces emulation on a monotonic nanosecond clock: each VI is due one VI
+ * period (divided by the pacing multiple) after the previous one, and we
+ * sleep until then. Running late doesn't move the schedule, unless we lag
+ * behind by more than PACING_MAX_LAG_NS (e.g. after a pause): there's no
+ * point in running fast to catch up then. */
 static void apply_speed_limiter(void)
 {
-    static unsigned long totalVIs = 0;
-    static int resetOnce = 0;
-    static int lastSpeedFactor = 100;
-    static unsigned int StartFPSTime = 0;
-    static const double defaultSpeedFactor = 100.0;
-    unsigned int CurrentFPSTime = SDL_GetTicks();
-    static double sleepTimes[SAMPLE_COUNT];
-    static unsigned int sleepTimesIndex = 0;
-
-    // calculate frame duration based upon ROM setting (50/60hz) and mupen64plus speed adjustment
-    const double VILimitMilliseconds = 1000.0 / g_dev.vi.expected_refresh_rate;
-    const double SpeedFactorMultiple = defaultSpeedFactor/l_SpeedFactor;
-    const double AdjustedLimit = VILimitMilliseconds * SpeedFactorMultiple;
-
-    //if this is the first time or we are resuming from pause
-    if(StartFPSTime == 0 || !resetOnce || lastSpeedFactor != l_SpeedFactor)
-    {
-       StartFPSTime = CurrentFPSTime;
-       totalVIs = 0;
-       resetOnce = 1;
-    }
-    else
-    {
-        ++totalVIs;
-    }
-
-    lastSpeedFactor = l_SpeedFactor;
+    int64_t now = osal_time_ns();
+    int64_t emulation_ns = now - l_PacingLastVI;
+    int64_t sleep_ns = 0;
+    int64_t overshoot_ns = 0;
+    double multiple;
 
 #if defined(PROFILE)
     timed_section_start(TIMED_SECTION_IDLE);
@@ -907,48 +991,94 @@ static void apply_speed_limiter(void)
     if(g_DebuggerActive) DebuggerCallback(DEBUG_UI_VI, 0);
 #endif
 
-    double totalElapsedGameTime = AdjustedLimit*totalVIs;
-    double elapsedRealTime = CurrentFPSTime - StartFPSTime;
-    double sleepTime = totalElapsedGameTime - elapsedRealTime;
-
-    //Reset if the sleep needed is an unreasonable value
-    static const double minSleepNeeded = -50;
-    static const double maxSleepNeeded = 50;
-    if(sleepTime < minSleepNeeded || sleepTime > (maxSleepNeeded*SpeedFactorMultiple))
+    switch (l_PacingMode)
     {
-       resetOnce = 0;
+        case PACING_UNCAPPED:
+            multiple = 0.0;
+            break;
+        case PACING_FIXED_MULTIPLE:
+            multiple = l_PacingMultiple;
+            break;
+        default:
+            multiple = l_SpeedFactor / 100.0;
+            break;
     }
 
-    sleepTimes[sleepTimesIndex%SAMPLE_COUNT] = sleepTime;
-    sleepTimesIndex++;
-
-    unsigned int elementsForAverage = sleepTimesIndex > SAMPLE_COUNT ? SAMPLE_COUNT : sleepTimesIndex;
-
-    // compute the average sleepTime
-    double sum = 0;
-    unsigned int index;
-    for(index = 0; index < elementsForAverage; index++)
+    if (!l_MainSpeedLimit || multiple <= 0.0 || g_dev.vi.expected_refresh_rate <= 0.0)
     {
-        sum += sleepTimes[index];
+        l_PacingDeadline = 0;
+        l_RenderBehind = 0;
     }
+    else
+    {
+        int64_t period = (int64_t)(1000000000.0 / (g_dev.vi.expected_refresh_rate * multiple));
 
-    double averageSleep = sum/elementsForAverage;
+        if (l_PacingDeadline == 0 || period != l_PacingPeriod)
+            l_PacingDeadline = now;
+        else
+            l_PacingDeadline += period;
+        l_PacingPeriod = period;
 
-    int sleepMs = (int)averageSleep;
+        if (now < l_PacingDeadline)
+        {
+            DebugMessage(M64MSG_VERBOSE, "    apply_speed_limiter(): Waiting %lldus", (long long)((l_PacingDeadline - now) / 1000));
 
-    if(sleepMs > 0 && sleepMs < maxSleepNeeded*SpeedFactorMultiple && l_MainSpeedLimit)
-    {
-       DebugMessage(M64MSG_VERBOSE, "    apply_speed_limiter(): Waiting %ims", sleepMs);
+            osal_sleep_until_ns(l_PacingDeadline);
+            sleep_ns = osal_time_ns() - now;
+            overshoot_ns = now + sleep_ns - l_PacingDeadline;
+        }
+        else
+        {
+            overshoot_ns = now - l_PacingDeadline;
+            if (overshoot_ns > PACING_MAX_LAG_NS)
+                l_PacingDeadline = now;
+        }
 
-       SDL_Delay(sleepMs);
+        /* the adaptive render skip policy drops frames while we lag behind */
+        l_RenderBehind = (sleep_ns == 0 && overshoot_ns > 0);
     }
 
+    l_PacingLastVI = now + sleep_ns;
+
+    SDL_LockMutex(l_PacingLock);
+    {
+        m64p_pacing_sample* sample = &l_PacingSamples[l_PacingVIs % PACING_SAMPLES];
+        sample->vi = ++l_PacingVIs;
+        sample->emulation_ns = emulation_ns;
+        sample->sleep_ns = sleep_ns;
+        sample->overshoot_ns = overshoot_ns;
+    }
+    SDL_UnlockMutex(l_PacingLock);
 
 #if defined(PROFILE)
     timed_section_end(TIMED_SECTION_IDLE);
 #endif
 }
 
+/* Copies the latest pacing samples, oldest first, to the count entries of
+ * samples. Entries left over are zeroed. */
+m64p_error main_get_pacing_samples(m64p_pacing_sample* samples, int count)
+{
+    unsigned int n, first, i;
+
+    if (samples == NULL || count < 0)
+        return M64ERR_INPUT_INVALID;
+
+    SDL_LockMutex(l_PacingLock);
+    n = l_PacingVIs;
+    if (n > PACING_SAMPLES)
+        n = PACING_SAMPLES;
+    if (n > (unsigned int)count)
+        n = count;
+    first = l_PacingVIs - n;
+    for (i = 0; i < n; ++i)
+        samples[i] = l_PacingSamples[(first + i) % PACING_SAMPLES];
+    SDL_UnlockMutex(l_PacingLock);
+
+    memset(samples + n, 0, (count - n) * sizeof(m64p_pacing_sample));
+    return M64ERR_SUCCESS;
+}
+
 /* TODO: make a GameShark module and move that there */
 static void gs_apply_cheats(struct cheat_ctx* ctx)
 {
@@ -977,6 +1107,10 @@ static void pause_loop(void)
             SDL_Delay(10);
             main_check_inputs();
         }
+
+        /* don't count the pause as emulation time */
+        l_PacingDeadline = 0;
+        l_PacingLastVI = osal_time_ns();
     }
 }
 
@@ -1470,6 +1604,7 @@ m64p_error main_run(void)
     int32_t si_dma_duration;
     int32_t no_compiled_jump;
     int32_t randomize_interrupt;
+    int32_t skip_polling_loops;
     struct file_storage eep;
     struct file_storage fla;
     struct file_storage sra;
@@ -1485,13 +1620,6 @@ m64p_error main_run(void)
     void* gbcam_backend;
     const struct video_capture_backend_interface* igbcam_backend;
 
-    const char *hook_path = ConfigGetParamString(g_CoreConfig, "PythonHookPath");
-    if (hook_path[0] != 0) {
-        pyLoadHooks(hook_path);
-    }
-
-
-
     /* XXX: select type of flashram from db */
     uint32_t flashram_type = MX29L1100_ID;
 
@@ -1504,6 +1632,7 @@ m64p_error main_run(void)
     no_compiled_jump = ConfigGetParamBool(g_CoreConfig, "NoCompiledJump");
     //We disable any randomness for netplay
     randomize_interrupt = !netplay_is_init() ? ConfigGetParamBool(g_CoreConfig, "RandomizeInterrupt") : 0;
+    skip_polling_loops = ConfigGetParamBool(g_CoreConfig, "SkipPollingLoops");
     count_per_op = ConfigGetParamInt(g_CoreConfig, "CountPerOp");
 
     if (ROM_SETTINGS.disableextramem)
@@ -1742,6 +1871,7 @@ m64p_error main_run(void)
                 count_per_op,
                 no_compiled_jump,
                 randomize_interrupt,
+                skip_polling_loops,
                 g_start_address,
                 &g_dev.ai, &g_iaudio_out_backend_plugin_compat,
                 si_dma_duration,
@@ -1759,6 +1889,18 @@ m64p_error main_run(void)
                 dd_rom_size,
                 &dd_disk, dd_idisk);
 
+    if (!call_hooks_parse(&g_dev.r4300.hooks.call_hooks, ConfigGetParamString(g_CoreConfig, "CallHooks")))
+        DebugMessage(M64MSG_WARNING, "Some call hooks could not be parsed and were ignored");
+
+#ifdef NEW_DYNAREC
+    new_dynarec_set_cache_size((size_t)ConfigGetParamInt(g_CoreConfig, "DynarecCacheSize") << 20);
+#endif
+
+    const char *hook_path = ConfigGetParamString(g_CoreConfig, "PythonHookPath");
+    if (hook_path[0] != 0) {
+        pyLoadHooks(&g_dev.r4300, hook_path);
+    }
+
     // Attach rom to plugins
     if (!gfx.romOpen())
     {
@@ -1777,7 +1919,7 @@ m64p_error main_run(void)
     event_initialize();
 
     /* initialize the on-screen display */
-    if (ConfigGetParamBool(g_CoreConfig, "OnScreenDisplay"))
+    if (l_OnScreenDisplay.integer)
     {
         // init on-screen display
         int width = 640, height = 480;
@@ -1810,9 +1952,40 @@ m64p_error main_run(void)
         StateChanged(M64CORE_EMU_STATE, M64EMU_RUNNING);
     }
 
+    fork_server_init();
+    perf_map_open();
+
+    g_dev.sp.async_tasks = ConfigGetParamBool(g_CoreConfig, "AsyncRsp") && rsp_worker_init() == 0;
+
+    l_PacingMode = ConfigGetParamInt(g_CoreConfig, "PacingMode");
+    l_PacingMultiple = ConfigGetParamFloat(g_CoreConfig, "PacingMultiple");
+    l_PacingDeadline = 0;
+    l_PacingLastVI = osal_time_ns();
+    l_PacingVIs = 0;
+    if (l_PacingLock == NULL)
+        l_PacingLock = SDL_CreateMutex();
+
+    l_RenderSkip = ConfigGetParamInt(g_CoreConfig, "RenderSkip");
+    l_RenderSkipFrames = ConfigGetParamInt(g_CoreConfig, "RenderSkipFrames");
+    l_RenderSkipped = 0;
+    l_RenderNextFrame = 0;
+    if (l_RenderSkip != RENDER_SKIP_OFF)
+        DebugMessage(M64MSG_INFO, "Render skip policy %d (%d frames)", l_RenderSkip, l_RenderSkipFrames);
+
     poweron_device(&g_dev);
     pif_bootrom_hle_execute(&g_dev.r4300);
+    osal_timer_begin();
     run_device(&g_dev);
+    osal_timer_end();
+
+    rsp_task_sync(&g_dev.sp);
+    g_dev.sp.async_tasks = 0;
+    rsp_worker_shutdown();
+
+    perf_map_close();
+
+    /* forked jobs report and exit here */
+    fork_server_shutdown(l_CurrentFrame);
 
     /* now begin to shut down */
 #ifdef WITH_LIRC
@@ -1840,7 +2013,7 @@ m64p_error main_run(void)
     close_file_storage(&mpk);
     close_dd_disk(&dd_disk);
 
-    if (ConfigGetParamBool(g_CoreConfig, "OnScreenDisplay"))
+    if (l_OnScreenDisplay.integer)
     {
         osd_exit();
     }
@@ -1850,6 +2023,9 @@ m64p_error main_run(void)
     audio.romClosed();
     gfx.romClosed();
 
+    release_device(&g_dev);
+    pyReleaseHooks(&g_dev.r4300);
+
     // clean up
     g_EmulatorRunning = 0;
     StateChanged(M64CORE_EMU_STATE, M64EMU_STOPPED);
@@ -1861,6 +2037,8 @@ on_input_open_failure:
 on_audio_open_failure:
     gfx.romClosed();
 on_gfx_open_failure:
+    pyReleaseHooks(&g_dev.r4300);
+
     /* release gb_carts */
     for(i = 0; i < GAME_CONTROLLERS_COUNT; ++i) {
         if (!Controls[i].RawData && g_dev.gb_carts[i].read_gb_cart != NULL) {
@@ -25,6 +25,7 @@
 
 #include <stdint.h>
 
+#include "api/config.h"
 #include "api/m64p_types.h"
 #include "main/cheat.h"
 #include "device/device.h"
@@ -36,9 +37,22 @@
 #define ATTR_FMT(fmtpos, attrpos)
 #endif
 
+enum render_skip_policy
+{
+    RENDER_SKIP_OFF,
+    RENDER_SKIP_FIXED,
+    RENDER_SKIP_ADAPTIVE,
+    RENDER_SKIP_NEVER
+};
+
 /* globals */
 extern m64p_handle g_CoreConfig;
 
+extern config_param g_RamDumpPath;
+extern config_param g_RamDumpStart;
+extern config_param g_RamDumpEnd;
+extern config_param g_RamDumpTrigger;
+
 extern int g_RomWordsLittleEndian;
 extern int g_EmulatorRunning;
 extern int g_rom_pause;
@@ -81,6 +95,9 @@ void main_rdram_dump(void);
 
 void main_take_next_screenshot(void);
 
+void main_render_next_frame(void);
+int main_render_frame(void);
+
 void main_state_set_slot(int slot);
 void main_state_inc_slot(void);
 void main_state_load(const char *filename);
@@ -92,6 +109,8 @@ m64p_error main_core_state_set(m64p_core_param param, int val);
 m64p_error main_get_screen_size(int *width, int *height);
 m64p_error main_read_screen(void *pixels, int bFront);
 
+m64p_error main_get_pacing_samples(m64p_pacing_sample* samples, int count);
+
 m64p_error main_volume_up(void);
 m64p_error main_volume_down(void);
 m64p_error main_volume_get_level(int *level);
@@ -0,0 +1,245 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - perf_map.c                                              *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "perf_map.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define M64P_CORE_PROTOTYPES 1
+#include "api/callbacks.h"
+#include "api/m64p_config.h"
+#include "api/m64p_types.h"
+#include "main/main.h"
+
+#define PERF_MAP_NAME_MAX 256
+
+struct perf_map_symbol
+{
+    uint32_t addr;
+    char* name;
+};
+
+static FILE* l_map = NULL;
+static char l_map_path[64];
+/* size of the map when the process was forked */
+static long l_map_fork_size = 0;
+
+static struct perf_map_symbol* l_symbols = NULL;
+static size_t l_symbols_count = 0;
+
+/*********************************************************************************************************
+* static functions
+*/
+
+static int compare_symbols(const void* a, const void* b)
+{
+    uint32_t addr_a = ((const struct perf_map_symbol*)a)->addr;
+    uint32_t addr_b = ((const struct perf_map_symbol*)b)->addr;
+
+    return (addr_a > addr_b) - (addr_a < addr_b);
+}
+
+/* Reads "<hex address> <name>" lines, as well as the linker script style
+ * "<name> = 0x<address>;" lines of the decompilation projects. */
+static void load_symbols(const char* path)
+{
+    char line[PERF_MAP_NAME_MAX + 64];
+    char name[PERF_MAP_NAME_MAX];
+    size_t symbols_max = 0;
+    unsigned int addr;
+    FILE* fPtr;
+
+    if ((fPtr = fopen(path, "r")) == NULL)
+    {
+        DebugMessage(M64MSG_WARNING, "Couldn't open perf map symbols file '%s'", path);
+        return;
+    }
+
+    while (fgets(line, sizeof(line), fPtr) != NULL)
+    {
+        if (sscanf(line, "%255s = %x", name, &addr) != 2
+         && sscanf(line, "%x %255s", &addr, name) != 2)
+            continue;
+
+        if (l_symbols_count == symbols_max)
+        {
+            size_t new_max = (symbols_max == 0) ? 1024 : 2 * symbols_max;
+            struct perf_map_symbol* new_symbols = realloc(l_symbols, new_max * sizeof(*new_symbols));
+            if (new_symbols == NULL)
+                break;
+            l_symbols = new_symbols;
+            symbols_max = new_max;
+        }
+
+        if ((l_symbols[l_symbols_count].name = strdup(name)) == NULL)
+            break;
+        l_symbols[l_symbols_count++].addr = (uint32_t)addr;
+    }
+
+    fclose(fPtr);
+
+    qsort(l_symbols, l_symbols_count, sizeof(*l_symbols), compare_symbols);
+    DebugMessage(M64MSG_INFO, "Loaded %u perf map symbols from '%s'", (unsigned int)l_symbols_count, path);
+}
+
+/* nearest symbol at or before vaddr */
+static const struct perf_map_symbol* find_symbol(uint32_t vaddr)
+{
+    size_t lo = 0;
+    size_t hi = l_symbols_count;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (l_symbols[mid].addr <= vaddr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return (lo == 0) ? NULL : &l_symbols[lo - 1];
+}
+
+static int is_rdram_address(uint32_t vaddr)
+{
+    return (vaddr & UINT32_C(0xc0000000)) == UINT32_C(0x80000000)
+        && (vaddr & UINT32_C(0x1fffffff)) < UINT32_C(0x800000);
+}
+
+/* code invalidation count of the RDRAM page of vaddr */
+static uint32_t get_generation(uint32_t vaddr)
+{
+    return is_rdram_address(vaddr) ? g_dev.r4300.cached_interp.invalidations[(vaddr >> 12) & 0x7ff] : 0;
+}
+
+/*********************************************************************************************************
+* global functions
+*/
+
+void perf_map_open(void)
+{
+    const char* symbols = ConfigGetParamString(g_CoreConfig, "PerfMapSymbols");
+
+    if (l_map != NULL)
+        return;
+
+    snprintf(l_map_path, sizeof(l_map_path), "/tmp/perf-%d.map", (int)getpid());
+    if ((l_map = fopen(l_map_path, "w")) == NULL)
+    {
+        DebugMessage(M64MSG_WARNING, "Couldn't open perf map '%s'", l_map_path);
+        return;
+    }
+
+    if (symbols != NULL && symbols[0] != '\0')
+        load_symbols(symbols);
+
+    DebugMessage(M64MSG_INFO, "Writing recompiled code map to '%s'", l_map_path);
+}
+
+void perf_map_close(void)
+{
+    size_t i;
+
+    if (l_map == NULL)
+        return;
+
+    fclose(l_map);
+    l_map = NULL;
+
+    for (i = 0; i < l_symbols_count; ++i)
+        free(l_symbols[i].name);
+    free(l_symbols);
+    l_symbols = NULL;
+    l_symbols_count = 0;
+}
+
+void perf_map_add(const void* code, size_t size, uint32_t vaddr)
+{
+    const struct perf_map_symbol* symbol;
+    char name[PERF_MAP_NAME_MAX + 32];
+    uint32_t generation;
+    int len;
+
+    if (l_map == NULL || size == 0)
+        return;
+
+    symbol = find_symbol(vaddr);
+    if (symbol == NULL)
+        len = snprintf(name, sizeof(name), "n64:%08" PRIX32, vaddr);
+    else if (symbol->addr == vaddr)
+        len = snprintf(name, sizeof(name), "n64:%s", symbol->name);
+    else
+        len = snprintf(name, sizeof(name), "n64:%s+0x%" PRIx32, symbol->name, vaddr - symbol->addr);
+
+    generation = get_generation(vaddr);
+    if (generation != 0 && len > 0 && (size_t)len < sizeof(name))
+        snprintf(name + len, sizeof(name) - len, ".g%" PRIu32, generation);
+
+    fprintf(l_map, "%" PRIxPTR " %zx %s\n", (uintptr_t)code, size, name);
+}
+
+void perf_map_before_fork(void)
+{
+    if (l_map == NULL)
+        return;
+
+    /* so that the child doesn't write the parent's buffered lines again */
+    fflush(l_map);
+    l_map_fork_size = ftell(l_map);
+}
+
+void perf_map_after_fork(void)
+{
+    char parent_path[sizeof(l_map_path)];
+    char buffer[4096];
+    long remaining = l_map_fork_size;
+    size_t len;
+    FILE* parent_map;
+
+    if (l_map == NULL)
+        return;
+
+    /* the stream was flushed before the fork, closing it writes nothing */
+    fclose(l_map);
+    strcpy(parent_path, l_map_path);
+
+    snprintf(l_map_path, sizeof(l_map_path), "/tmp/perf-%d.map", (int)getpid());
+    if ((l_map = fopen(l_map_path, "w")) == NULL)
+    {
+        DebugMessage(M64MSG_WARNING, "Couldn't open perf map '%s'", l_map_path);
+        return;
+    }
+
+    /* the code recompiled by the parent is still there */
+    if ((parent_map = fopen(parent_path, "r")) != NULL)
+    {
+        while (remaining > 0 && (len = fread(buffer, 1, (remaining < (long)sizeof(buffer)) ? (size_t)remaining : sizeof(buffer), parent_map)) > 0)
+        {
+            fwrite(buffer, 1, len, l_map);
+            remaining -= (long)len;
+        }
+        fclose(parent_map);
+    }
+}
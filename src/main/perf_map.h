@@ -0,0 +1,79 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - perf_map.h                                              *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef __PERF_MAP_H__
+#define __PERF_MAP_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "osal/preproc.h"
+
+/* The perf map tells Linux perf which guest code each block of recompiled
+ * code comes from, so that "perf record" and "perf report" show guest
+ * functions instead of anonymous addresses.
+ *
+ * Each recompiled block gets a line in /tmp/perf-<pid>.map, named after the
+ * guest virtual address of its entry point (n64:80246000), or after the
+ * nearest symbol of the map set in the "PerfMapSymbols" parameter
+ * (n64:func_80246000+0x1c). The perf map format cannot tell when code goes
+ * away, so blocks recompiled after an invalidation of their RDRAM page get
+ * a generation suffix (n64:80246000.g2), which is the code invalidation
+ * count of the page (see cached_interp.invalidations).
+ *
+ * A forked child gets its own map, starting with the lines the parent had
+ * written before the fork since it inherits the recompiled code. */
+
+#ifdef M64P_PERF_MAP
+
+void perf_map_open(void);
+void perf_map_close(void);
+void perf_map_add(const void* code, size_t size, uint32_t vaddr);
+/* to be called right before fork() */
+void perf_map_before_fork(void);
+/* to be called in the child, right after fork() */
+void perf_map_after_fork(void);
+
+#else
+
+static osal_inline void perf_map_open(void)
+{
+}
+
+static osal_inline void perf_map_close(void)
+{
+}
+
+static osal_inline void perf_map_add(const void* code, size_t size, uint32_t vaddr)
+{
+}
+
+static osal_inline void perf_map_before_fork(void)
+{
+}
+
+static osal_inline void perf_map_after_fork(void)
+{
+}
+
+#endif
+
+#endif
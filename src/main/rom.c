@@ -26,6 +26,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
@@ -38,10 +40,26 @@
 #include "device/device.h"
 #include "main.h"
 #include "md5.h"
+#include "osal/files.h"
 #include "osal/preproc.h"
 #include "osd/osd.h"
 #include "rom.h"
 #include "util.h"
+#include "workqueue.h"
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+#include <SDL.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(WIN32) && !defined(__MINGW32__)
+  #include <process.h>
+  #define getpid _getpid
+#endif
 
 #define CHUNKSIZE 1024*128 /* Read files 128KB at a time. */
 
@@ -53,6 +71,8 @@ enum { DEFAULT_DISABLE_EXTRA_MEM = 0 };
 enum { DEFAULT_SI_DMA_DURATION = 0x900 };
 
 static romdatabase_entry* ini_search_by_md5(md5_byte_t* md5);
+static romdatabase_entry* index_search_by_md5(md5_byte_t* md5);
+static romdatabase_entry* index_search_by_crc(unsigned int crc1, unsigned int crc2);
 
 static _romdatabase g_romdatabase;
 
@@ -80,6 +100,51 @@ static int is_valid_rom(const unsigned char *buffer)
         return 0;
 }
 
+static void swap16_copy(uint16_t* dst16, const uint16_t* src16, size_t len)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) src16);
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*) dst16, v);
+        src16 += 8;
+        dst16 += 8;
+    }
+#endif
+
+    for (; i < len; i += 2)
+    {
+        *dst16++ = m64p_swap16(*src16++);
+    }
+}
+
+static void swap32_copy(uint32_t* dst32, const uint32_t* src32, size_t len)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) src32);
+        /* swap the bytes of each half-word, then the half-words of each word */
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128((__m128i*) dst32, v);
+        src32 += 4;
+        dst32 += 4;
+    }
+#endif
+
+    for (; i < len; i += 4)
+    {
+        *dst32++ = m64p_swap32(*src32++);
+    }
+}
+
 /* Copies the source block of memory to the destination block of memory while
  * switching the endianness of .v64 and .n64 images to the .z64 format, which
  * is native to the Nintendo 64. The data extraction routines and MD5 hashing
@@ -99,29 +164,15 @@ static void swap_copy_rom(void* dst, const void* src, size_t len, unsigned char*
 {
     if (memcmp(src, V64_SIGNATURE, sizeof(V64_SIGNATURE)) == 0)
     {
-        size_t i;
-        const uint16_t* src16 = (const uint16_t*) src;
-        uint16_t* dst16 = (uint16_t*) dst;
-
         *imagetype = V64IMAGE;
         /* .v64 images have byte-swapped half-words (16-bit). */
-        for (i = 0; i < len; i += 2)
-        {
-            *dst16++ = m64p_swap16(*src16++);
-        }
+        swap16_copy((uint16_t*) dst, (const uint16_t*) src, len);
     }
     else if (memcmp(src, N64_SIGNATURE, sizeof(N64_SIGNATURE)) == 0)
     {
-        size_t i;
-        const uint32_t* src32 = (const uint32_t*) src;
-        uint32_t* dst32 = (uint32_t*) dst;
-
         *imagetype = N64IMAGE;
         /* .n64 images have byte-swapped words (32-bit). */
-        for (i = 0; i < len; i += 4)
-        {
-            *dst32++ = m64p_swap32(*src32++);
-        }
+        swap32_copy((uint32_t*) dst, (const uint32_t*) src, len);
     }
     else {
         *imagetype = Z64IMAGE;
@@ -129,13 +180,197 @@ static void swap_copy_rom(void* dst, const void* src, size_t len, unsigned char*
     }
 }
 
-m64p_error open_rom(const unsigned char* romimage, unsigned int size)
+/* MD5 of the rom image, computed on the work queue while open_rom looks the
+ * rom up in the id cache. It is hashed in chunks, so that a cache hit can
+ * stop it early. */
+#define ROM_MD5_CHUNK_SIZE (1024*1024)
+
+struct rom_md5_work
+{
+    struct work_struct work;
+    const md5_byte_t* data;
+    size_t len;
+    md5_byte_t digest[16];
+    volatile int cancel;
+    SDL_sem* done;
+};
+
+static void rom_md5_work_func(struct work_struct *work)
 {
+    struct rom_md5_work* md5_work = container_of(work, struct rom_md5_work, work);
+    md5_state_t state;
+    size_t offset, len;
+
+    md5_init(&state);
+    for (offset = 0; offset < md5_work->len && !md5_work->cancel; offset += len)
+    {
+        len = md5_work->len - offset;
+        if (len > ROM_MD5_CHUNK_SIZE)
+            len = ROM_MD5_CHUNK_SIZE;
+        md5_append(&state, md5_work->data + offset, (int) len);
+    }
+    md5_finish(&state, md5_work->digest);
+
+    SDL_SemPost(md5_work->done);
+}
+
+/* The rom id cache maps a content id (XXH3 of the image, or of the file
+ * path, mtime and size) to the MD5 of the image, so that reopening a known
+ * rom doesn't have to hash it again. It is a text file in the user cache
+ * directory, with one "<id> <md5>" line per rom, oldest first. It holds at
+ * most ROMID_CACHE_MAX_ENTRIES lines, older ones are dropped on store. */
+#define ROMID_CACHE_MAX_ENTRIES 256
+#define ROMID_CACHE_LINE_LEN (16 + 1 + 32 + 1)
+
+static const char* romid_cache_path(const char* suffix)
+{
+    static char path[PATH_MAX];
+    const char* cache_dir = ConfigGetUserCachePath();
+    size_t len;
+
+    if (cache_dir == NULL || cache_dir[0] == '\0')
+        return NULL;
+
+    len = strlen(cache_dir);
+    snprintf(path, sizeof(path), "%s%sromid.cache%s", cache_dir,
+             (strchr(OSAL_DIR_SEPARATORS, cache_dir[len-1]) != NULL) ? "" : "/", suffix);
+    return path;
+}
+
+static int romid_cache_lookup(uint64_t id, md5_byte_t* digest)
+{
+    const char* path = romid_cache_path("");
+    char line[64];
+    char md5[33];
+    uint64_t line_id;
+    FILE* fPtr;
+    int found = 0;
+
+    if (path == NULL || (fPtr = fopen(path, "r")) == NULL)
+        return 0;
+
+    while (!found && fgets(line, sizeof(line), fPtr) != NULL)
+    {
+        if (sscanf(line, "%16" SCNx64 " %32s", &line_id, md5) == 2 && line_id == id)
+            found = parse_hex(md5, digest, 16);
+    }
+
+    fclose(fPtr);
+    return found;
+}
+
+/* Rewrites the cache with its newest entries, keeping room for one more */
+static void romid_cache_compact(void)
+{
+    char (*lines)[ROMID_CACHE_LINE_LEN + 1];
+    char line[64];
+    char path[PATH_MAX];
+    char tmp_suffix[32];
+    const char* tmp_path;
+    size_t count = 0, first, i;
+    FILE* fPtr;
+
+    /* the path buffer is shared, keep a copy before building tmp_path */
+    if ((tmp_path = romid_cache_path("")) == NULL)
+        return;
+    strcpy(path, tmp_path);
+
+    if ((fPtr = fopen(path, "r")) == NULL)
+        return;
+
+    /* ring of the last ROMID_CACHE_MAX_ENTRIES - 1 lines */
+    lines = malloc((ROMID_CACHE_MAX_ENTRIES - 1) * sizeof(*lines));
+    if (lines == NULL)
+    {
+        fclose(fPtr);
+        return;
+    }
+
+    while (fgets(line, sizeof(line), fPtr) != NULL)
+    {
+        if (strlen(line) != ROMID_CACHE_LINE_LEN)
+            continue;
+        memcpy(lines[count % (ROMID_CACHE_MAX_ENTRIES - 1)], line, ROMID_CACHE_LINE_LEN + 1);
+        ++count;
+    }
+    fclose(fPtr);
+
+    /* write a new file and move it over the old one, so that concurrent
+     * startups never read a partially written cache */
+    snprintf(tmp_suffix, sizeof(tmp_suffix), ".%d.tmp", (int) getpid());
+    tmp_path = romid_cache_path(tmp_suffix);
+    if ((fPtr = fopen(tmp_path, "w")) != NULL)
+    {
+        first = (count > ROMID_CACHE_MAX_ENTRIES - 1) ? count - (ROMID_CACHE_MAX_ENTRIES - 1) : 0;
+        for (i = first; i < count; ++i)
+            fputs(lines[i % (ROMID_CACHE_MAX_ENTRIES - 1)], fPtr);
+        fclose(fPtr);
+
+        if (osal_file_replace(tmp_path, path) != 0)
+            remove(tmp_path);
+    }
+
+    free(lines);
+}
+
+static void romid_cache_store(uint64_t id, const md5_byte_t* digest)
+{
+    const char* path = romid_cache_path("");
+    char line[64];
+    int i, len;
+    size_t count = 0;
+    FILE* fPtr;
+
+    if (path == NULL)
+        return;
+
+    /* only done on a cache miss, when the whole rom was just hashed */
+    if ((fPtr = fopen(path, "r")) != NULL)
+    {
+        while (fgets(line, sizeof(line), fPtr) != NULL)
+            ++count;
+        fclose(fPtr);
+    }
+
+    if (count >= ROMID_CACHE_MAX_ENTRIES)
+        romid_cache_compact();
+
+    if ((path = romid_cache_path("")) == NULL || (fPtr = fopen(path, "a")) == NULL)
+        return;
+
+    /* a single write per line, so that concurrent appends don't interleave */
+    len = snprintf(line, sizeof(line), "%016" PRIx64 " ", id);
+    for (i = 0; i < 16; ++i)
+        len += snprintf(line + len, sizeof(line) - len, "%02X", digest[i]);
+    line[len++] = '\n';
+    fwrite(line, 1, len, fPtr);
+    fclose(fPtr);
+}
+
+static uint64_t romid_of_file(const char* path, const struct stat* file_stat)
+{
+    XXH3_state_t hash;
+    int64_t mtime = (int64_t) file_stat->st_mtime;
+    int64_t size = (int64_t) file_stat->st_size;
+
+    XXH3_64bits_reset(&hash);
+    XXH3_64bits_update(&hash, path, strlen(path) + 1);
+    XXH3_64bits_update(&hash, &mtime, sizeof(mtime));
+    XXH3_64bits_update(&hash, &size, sizeof(size));
+    return XXH3_64bits_digest(&hash);
+}
+
+static m64p_error open_rom_image(const unsigned char* romimage, unsigned int size, const uint64_t* file_id)
+{
+    struct rom_md5_work md5_work;
     md5_state_t state;
     md5_byte_t digest[16];
     romdatabase_entry* entry;
     char buffer[256];
     unsigned char imagetype;
+    const uint8_t* rom;
+    uint64_t id;
+    int have_digest;
     int i;
 
     /* check input requirements */
@@ -151,17 +386,47 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
     g_rom_size = size;
     swap_copy_rom((uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM), romimage, size, &imagetype);
     /* ROM is now in N64 native (big endian) byte order */
+    rom = (const uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM);
 
-    memcpy(&ROM_HEADER, (uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM), sizeof(m64p_rom_header));
+    memcpy(&ROM_HEADER, rom, sizeof(m64p_rom_header));
 
-    /* Calculate MD5 hash  */
-    md5_init(&state);
-    md5_append(&state, (const md5_byte_t*)((uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM)), g_rom_size);
-    md5_finish(&state, digest);
-    for ( i = 0; i < 16; ++i )
-        sprintf(buffer+i*2, "%02X", digest[i]);
-    buffer[32] = '\0';
-    strcpy(ROM_SETTINGS.MD5, buffer);
+    /* Look up the MD5 hash in the rom id cache, otherwise calculate it.
+     * A mapped file has a cheap id, so it is looked up first. A buffer is
+     * identified by the XXH3 of its content: that pass overlaps with the
+     * MD5 on the work queue, which is stopped if the cache has the rom. */
+    md5_work.done = (file_id == NULL) ? SDL_CreateSemaphore(0) : NULL;
+    if (md5_work.done != NULL)
+    {
+        init_work(&md5_work.work, rom_md5_work_func);
+        md5_work.data = (const md5_byte_t*) rom;
+        md5_work.len = g_rom_size;
+        md5_work.cancel = 0;
+        queue_work(&md5_work.work);
+
+        id = XXH3_64bits(rom, g_rom_size);
+        have_digest = romid_cache_lookup(id, digest);
+        md5_work.cancel = have_digest;
+
+        SDL_SemWait(md5_work.done);
+        SDL_DestroySemaphore(md5_work.done);
+        if (!have_digest)
+        {
+            memcpy(digest, md5_work.digest, sizeof(digest));
+            romid_cache_store(id, digest);
+        }
+    }
+    else
+    {
+        id = (file_id != NULL) ? *file_id : XXH3_64bits(rom, g_rom_size);
+        have_digest = romid_cache_lookup(id, digest);
+        if (!have_digest)
+        {
+            md5_init(&state);
+            md5_append(&state, (const md5_byte_t*) rom, g_rom_size);
+            md5_finish(&state, digest);
+            romid_cache_store(id, digest);
+        }
+    }
 
     /* add some useful properties to ROM_PARAMS */
     ROM_PARAMS.systemtype = rom_country_code_to_system_type(ROM_HEADER.Country_code);
@@ -171,6 +436,11 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
     ROM_PARAMS.headername[20] = '\0';
     trim(ROM_PARAMS.headername); /* Remove trailing whitespace from ROM name. */
 
+    for ( i = 0; i < 16; ++i )
+        sprintf(buffer+i*2, "%02X", digest[i]);
+    buffer[32] = '\0';
+    strcpy(ROM_SETTINGS.MD5, buffer);
+
     /* Look up this ROM in the .ini file and fill in goodname, etc */
     if ((entry=ini_search_by_md5(digest)) != NULL ||
         (entry=ini_search_by_crc(tohl(ROM_HEADER.CRC1),tohl(ROM_HEADER.CRC2))) != NULL)
@@ -229,6 +499,39 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
     return M64ERR_SUCCESS;
 }
 
+m64p_error open_rom(const unsigned char* romimage, unsigned int size)
+{
+    return open_rom_image(romimage, size, NULL);
+}
+
+m64p_error open_rom_file(const char* path)
+{
+    struct stat file_stat;
+    unsigned char* romimage;
+    size_t size;
+    uint64_t id;
+    m64p_error rval;
+
+    if (stat(path, &file_stat) != 0 || (romimage = osal_file_map(path, &size)) == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "open_rom_file(): couldn't map '%s'", path);
+        return M64ERR_FILES;
+    }
+
+    if (size < 4096 || size > UINT32_MAX)
+    {
+        DebugMessage(M64MSG_ERROR, "open_rom_file(): invalid ROM size for '%s'", path);
+        osal_file_unmap(romimage, size);
+        return M64ERR_INPUT_INVALID;
+    }
+
+    id = romid_of_file(path, &file_stat);
+    rval = open_rom_image(romimage, (unsigned int) size, &id);
+
+    osal_file_unmap(romimage, size);
+    return rval;
+}
+
 m64p_error close_rom(void)
 {
     /* Clear Byte-swapped flag, since ROM is now deleted. */
@@ -393,6 +696,331 @@ static void romdatabase_resolve(void)
     } while (skipped > 0);
 }
 
+/********************************************************************************************/
+/* Binary index of the rom database
+ *
+ * Parsing mupen64plus.ini takes a large share of the core startup time, so the
+ * resolved database is saved in the user cache directory as a binary index and
+ * mapped back in on the next startup, as long as the ini file is unchanged.
+ *
+ * Layout: header, entries sorted by MD5 (string pointers stored as offsets in
+ * the string table), indices of the CRC-indexed entries sorted by CRC pair,
+ * string table.
+ */
+
+#define ROMDB_INDEX_MAGIC "M64PRDB"
+#define ROMDB_INDEX_VERSION 1
+
+/* entry string pointers are still string table offsets */
+#define ROMDATABASE_ENTRY_UNRESOLVED BIT(31)
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    int64_t ini_mtime;
+    uint64_t ini_size;
+    uint64_t ini_hash;
+    uint64_t body_hash;
+    uint32_t entry_count;
+    uint32_t crc_count;
+    uint32_t strings_size;
+    uint32_t reserved;
+} romdb_index_header;
+
+typedef struct
+{
+    romdatabase_search* search;
+    uint32_t order;
+} romdb_index_item;
+
+static const char* romdatabase_index_path(const char* ini_path)
+{
+    static char path[PATH_MAX];
+    const char* cache_dir = ConfigGetUserCachePath();
+    size_t len;
+
+    if (cache_dir == NULL || cache_dir[0] == '\0')
+        return NULL;
+
+    len = strlen(cache_dir);
+    snprintf(path, sizeof(path), "%s%sromdb-%016" PRIx64 ".bin", cache_dir,
+             (strchr(OSAL_DIR_SEPARATORS, cache_dir[len-1]) != NULL) ? "" : "/",
+             (uint64_t) XXH3_64bits(ini_path, strlen(ini_path)));
+    return path;
+}
+
+static size_t romdatabase_index_body_size(const romdb_index_header* header)
+{
+    return (size_t) header->entry_count * sizeof(romdatabase_entry)
+         + (size_t) header->crc_count * sizeof(uint32_t)
+         + header->strings_size;
+}
+
+static int romdatabase_index_load(const char* ini_path, const struct stat* ini_stat, uint64_t ini_hash)
+{
+    const char* path = romdatabase_index_path(ini_path);
+    romdb_index_header* header;
+    unsigned char* index;
+    size_t size;
+
+    if (path == NULL || (index = osal_file_map(path, &size)) == NULL)
+        return 0;
+
+    header = (romdb_index_header*) index;
+    if (size < sizeof(*header)
+     || memcmp(header->magic, ROMDB_INDEX_MAGIC, sizeof(header->magic)) != 0
+     || header->version != ROMDB_INDEX_VERSION
+     || header->entry_size != sizeof(romdatabase_entry)
+     || header->ini_mtime != (int64_t) ini_stat->st_mtime
+     || header->ini_size != (uint64_t) ini_stat->st_size
+     || header->ini_hash != ini_hash
+     || size != sizeof(*header) + romdatabase_index_body_size(header)
+     || header->body_hash != XXH3_64bits(index + sizeof(*header), size - sizeof(*header)))
+    {
+        osal_file_unmap(index, size);
+        return 0;
+    }
+
+    g_romdatabase.index = index;
+    g_romdatabase.index_size = size;
+    return 1;
+}
+
+static int romdb_index_item_cmp_md5(const void* a, const void* b)
+{
+    const romdb_index_item* ia = (const romdb_index_item*) a;
+    const romdb_index_item* ib = (const romdb_index_item*) b;
+    int cmp = memcmp(ia->search->entry.md5, ib->search->entry.md5, 16);
+
+    /* keep file order for duplicates; the last one wins, as in the lists */
+    if (cmp == 0)
+        cmp = (ia->order > ib->order) - (ia->order < ib->order);
+    return cmp;
+}
+
+static const romdatabase_entry* romdb_index_entries;
+
+static int romdb_index_crc_cmp(const void* a, const void* b)
+{
+    const romdatabase_entry* ea = &romdb_index_entries[*(const uint32_t*) a];
+    const romdatabase_entry* eb = &romdb_index_entries[*(const uint32_t*) b];
+
+    if (ea->crc1 != eb->crc1)
+        return (ea->crc1 > eb->crc1) ? 1 : -1;
+    if (ea->crc2 != eb->crc2)
+        return (ea->crc2 > eb->crc2) ? 1 : -1;
+    return (*(const uint32_t*) a > *(const uint32_t*) b) - (*(const uint32_t*) a < *(const uint32_t*) b);
+}
+
+static int romdatabase_in_crc_list(const romdatabase_search* search)
+{
+    const romdatabase_search* node;
+
+    for (node = g_romdatabase.crc_lists[search->entry.crc1 >> 24]; node != NULL; node = node->next_crc)
+    {
+        if (node == search)
+            return 1;
+    }
+    return 0;
+}
+
+static uint32_t romdb_index_add_string(char* strings, uint32_t* strings_size, const char* string)
+{
+    uint32_t offset = *strings_size;
+
+    if (string == NULL)
+        return 0;
+
+    strcpy(strings + offset, string);
+    *strings_size += (uint32_t) strlen(string) + 1;
+    return offset;
+}
+
+static void romdatabase_index_write(const char* ini_path, const struct stat* ini_stat, uint64_t ini_hash)
+{
+    const char* path = romdatabase_index_path(ini_path);
+    romdb_index_header header;
+    romdb_index_item* items = NULL;
+    romdatabase_entry* entries = NULL;
+    uint32_t* crcs = NULL;
+    char* strings = NULL;
+    romdatabase_search* search;
+    size_t strings_max = 1;
+    uint32_t count = 0, crc_count = 0, strings_size = 1, i;
+    char tmp_path[PATH_MAX];
+    XXH3_state_t hash;
+    FILE* fPtr;
+
+    if (path == NULL)
+        return;
+
+    for (search = g_romdatabase.list; search != NULL; search = search->next_entry)
+    {
+        ++count;
+        if (search->entry.goodname != NULL)
+            strings_max += strlen(search->entry.goodname) + 1;
+        if (search->entry.cheats != NULL)
+            strings_max += strlen(search->entry.cheats) + 1;
+    }
+
+    items = malloc(count * sizeof(*items));
+    entries = malloc(count * sizeof(*entries));
+    crcs = malloc(count * sizeof(*crcs));
+    strings = malloc(strings_max);
+    if ((count > 0 && (items == NULL || entries == NULL || crcs == NULL)) || strings == NULL)
+        goto cleanup;
+
+    for (search = g_romdatabase.list, i = 0; search != NULL; search = search->next_entry, ++i)
+    {
+        items[i].search = search;
+        items[i].order = i;
+    }
+    qsort(items, count, sizeof(*items), romdb_index_item_cmp_md5);
+
+    /* offset 0 of the string table stands for NULL */
+    strings[0] = '\0';
+    for (i = 0; i < count; ++i)
+    {
+        entries[i] = items[i].search->entry;
+        entries[i].goodname = (char*) (uintptr_t) romdb_index_add_string(strings, &strings_size, entries[i].goodname);
+        entries[i].cheats = (char*) (uintptr_t) romdb_index_add_string(strings, &strings_size, entries[i].cheats);
+        entries[i].refmd5 = NULL;
+        entries[i].set_flags |= ROMDATABASE_ENTRY_UNRESOLVED;
+
+        if (romdatabase_in_crc_list(items[i].search))
+            crcs[crc_count++] = i;
+    }
+    romdb_index_entries = entries;
+    qsort(crcs, crc_count, sizeof(*crcs), romdb_index_crc_cmp);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ROMDB_INDEX_MAGIC, sizeof(header.magic));
+    header.version = ROMDB_INDEX_VERSION;
+    header.entry_size = sizeof(romdatabase_entry);
+    header.ini_mtime = (int64_t) ini_stat->st_mtime;
+    header.ini_size = (uint64_t) ini_stat->st_size;
+    header.ini_hash = ini_hash;
+    header.entry_count = count;
+    header.crc_count = crc_count;
+    header.strings_size = strings_size;
+
+    XXH3_64bits_reset(&hash);
+    XXH3_64bits_update(&hash, entries, count * sizeof(*entries));
+    XXH3_64bits_update(&hash, crcs, crc_count * sizeof(*crcs));
+    XXH3_64bits_update(&hash, strings, strings_size);
+    header.body_hash = XXH3_64bits_digest(&hash);
+
+    /* write to a temporary file, then rename it over the index, so that
+     * concurrent startups never map a partially written index */
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", path, (int) getpid());
+    if ((fPtr = fopen(tmp_path, "wb")) == NULL)
+    {
+        DebugMessage(M64MSG_WARNING, "Unable to write rom database index '%s'.", tmp_path);
+        goto cleanup;
+    }
+
+    if (fwrite(&header, sizeof(header), 1, fPtr) != 1
+     || fwrite(entries, sizeof(*entries), count, fPtr) != count
+     || fwrite(crcs, sizeof(*crcs), crc_count, fPtr) != crc_count
+     || fwrite(strings, 1, strings_size, fPtr) != strings_size)
+    {
+        DebugMessage(M64MSG_WARNING, "Unable to write rom database index '%s'.", tmp_path);
+        fclose(fPtr);
+        remove(tmp_path);
+        goto cleanup;
+    }
+    fclose(fPtr);
+
+    if (osal_file_replace(tmp_path, path) != 0)
+        remove(tmp_path);
+
+cleanup:
+    free(items);
+    free(entries);
+    free(crcs);
+    free(strings);
+}
+
+static romdatabase_entry* romdatabase_index_resolve(romdatabase_entry* entry)
+{
+    const romdb_index_header* header = (const romdb_index_header*) g_romdatabase.index;
+    const char* strings = (const char*) g_romdatabase.index + g_romdatabase.index_size - header->strings_size;
+    uintptr_t offset;
+
+    /* the mapping is private, so string pointers are patched in place on first use */
+    if (entry->set_flags & ROMDATABASE_ENTRY_UNRESOLVED)
+    {
+        offset = (uintptr_t) entry->goodname;
+        entry->goodname = (offset != 0) ? (char*) strings + offset : NULL;
+        offset = (uintptr_t) entry->cheats;
+        entry->cheats = (offset != 0) ? (char*) strings + offset : NULL;
+        entry->set_flags &= ~ROMDATABASE_ENTRY_UNRESOLVED;
+    }
+
+    return entry;
+}
+
+static romdatabase_entry* index_search_by_md5(md5_byte_t* md5)
+{
+    const romdb_index_header* header = (const romdb_index_header*) g_romdatabase.index;
+    romdatabase_entry* entries = (romdatabase_entry*) (g_romdatabase.index + sizeof(*header));
+    uint32_t lo = 0, hi = header->entry_count, mid;
+
+    /* find the last entry with this MD5 */
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (memcmp(entries[mid].md5, md5, 16) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == 0 || memcmp(entries[lo-1].md5, md5, 16) != 0)
+        return NULL;
+
+    return romdatabase_index_resolve(&entries[lo-1]);
+}
+
+static romdatabase_entry* index_search_by_crc(unsigned int crc1, unsigned int crc2)
+{
+    const romdb_index_header* header = (const romdb_index_header*) g_romdatabase.index;
+    romdatabase_entry* entries = (romdatabase_entry*) (g_romdatabase.index + sizeof(*header));
+    const uint32_t* crcs = (const uint32_t*) (entries + header->entry_count);
+    uint32_t lo = 0, hi = header->crc_count, mid;
+    romdatabase_entry* entry;
+
+    /* find the first entry with this CRC pair */
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        entry = &entries[crcs[mid]];
+        if (entry->crc1 < crc1 || (entry->crc1 == crc1 && entry->crc2 < crc2))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == header->crc_count)
+        return NULL;
+
+    entry = &entries[crcs[lo]];
+    if (entry->crc1 != crc1 || entry->crc2 != crc2)
+        return NULL;
+
+    /* ambiguous CRCs give no match, as with the lists */
+    if (lo + 1 < header->crc_count)
+    {
+        const romdatabase_entry* next = &entries[crcs[lo+1]];
+        if (next->crc1 == crc1 && next->crc2 == crc2)
+            return NULL;
+    }
+
+    return romdatabase_index_resolve(entry);
+}
+
 /********************************************************************************************/
 /* INI Rom database functions */
 
@@ -406,12 +1034,16 @@ void romdatabase_open(void)
     int counter, value, lineno;
     unsigned char index;
     const char *pathname = ConfigGetSharedDataFilepath("mupen64plus.ini");
+    struct stat ini_stat;
+    uint64_t ini_hash = 0;
+    unsigned char* ini_data;
+    size_t ini_size;
 
     if(g_romdatabase.have_database)
         return;
 
     /* Open romdatabase. */
-    if (pathname == NULL || (fPtr = fopen(pathname, "rb")) == NULL)
+    if (pathname == NULL || stat(pathname, &ini_stat) != 0 || (fPtr = fopen(pathname, "rb")) == NULL)
     {
         DebugMessage(M64MSG_ERROR, "Unable to open rom database file '%s'.", pathname);
         return;
@@ -419,6 +1051,19 @@ void romdatabase_open(void)
 
     g_romdatabase.have_database = 1;
 
+    /* Use the binary index if it is up to date with the ini file */
+    if ((ini_data = osal_file_map(pathname, &ini_size)) != NULL)
+    {
+        ini_hash = XXH3_64bits(ini_data, ini_size);
+        osal_file_unmap(ini_data, ini_size);
+
+        if (romdatabase_index_load(pathname, &ini_stat, ini_hash))
+        {
+            fclose(fPtr);
+            return;
+        }
+    }
+
     /* Clear premade indices. */
     for(counter = 0; counter < 255; ++counter)
         g_romdatabase.crc_lists[counter] = NULL;
@@ -675,6 +1320,9 @@ void romdatabase_open(void)
 
     fclose(fPtr);
     romdatabase_resolve();
+
+    if (ini_data != NULL)
+        romdatabase_index_write(pathname, &ini_stat, ini_hash);
 }
 
 void romdatabase_close(void)
@@ -682,6 +1330,13 @@ void romdatabase_close(void)
     if (!g_romdatabase.have_database)
         return;
 
+    if (g_romdatabase.index != NULL)
+    {
+        osal_file_unmap(g_romdatabase.index, g_romdatabase.index_size);
+        g_romdatabase.index = NULL;
+        g_romdatabase.index_size = 0;
+    }
+
     while (g_romdatabase.list != NULL)
         {
         romdatabase_search* search = g_romdatabase.list->next_entry;
@@ -693,6 +1348,7 @@ void romdatabase_close(void)
         free(g_romdatabase.list);
         g_romdatabase.list = search;
         }
+    g_romdatabase.have_database = 0;
 }
 
 static romdatabase_entry* ini_search_by_md5(md5_byte_t* md5)
@@ -702,6 +1358,9 @@ static romdatabase_entry* ini_search_by_md5(md5_byte_t* md5)
     if(!g_romdatabase.have_database)
         return NULL;
 
+    if (g_romdatabase.index != NULL)
+        return index_search_by_md5(md5);
+
     search = g_romdatabase.md5_lists[md5[0]];
 
     while (search != NULL && memcmp(search->entry.md5, md5, 16) != 0)
@@ -721,6 +1380,9 @@ romdatabase_entry* ini_search_by_crc(unsigned int crc1, unsigned int crc2)
     if(!g_romdatabase.have_database) 
         return NULL;
 
+    if (g_romdatabase.index != NULL)
+        return index_search_by_crc(crc1, crc2);
+
     search = g_romdatabase.crc_lists[((crc1 >> 24) & 0xff)];
 
     // because CRCs can be ambiguous (there can be multiple database entries with the same CRC),
@@ -39,6 +39,7 @@
 /* ROM Loading and Saving functions */
 
 m64p_error open_rom(const unsigned char* romimage, unsigned int size);
+m64p_error open_rom_file(const char* path);
 m64p_error close_rom(void);
 
 extern int g_rom_size;
@@ -145,6 +146,9 @@ typedef struct
     romdatabase_search* crc_lists[256];
     romdatabase_search* md5_lists[256];
     romdatabase_search* list;
+    /* binary index mapped from the user cache; replaces the lists when set */
+    unsigned char* index;
+    size_t index_size;
 } _romdatabase;
 
 void romdatabase_open(void);
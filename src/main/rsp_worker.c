@@ -0,0 +1,131 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rsp_worker.c                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "rsp_worker.h"
+
+#include <SDL.h>
+#include <SDL_thread.h>
+#include <stddef.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "plugin/plugin.h"
+
+static SDL_Thread* l_thread = NULL;
+static SDL_sem* l_task_start = NULL;
+static SDL_sem* l_task_done = NULL;
+static volatile int l_quit = 0;
+
+static int rsp_worker_thread(void* data)
+{
+    for (;;) {
+        SDL_SemWait(l_task_start);
+        if (l_quit)
+            break;
+
+        rsp.doRspCycles(0xffffffff);
+
+        /* the semaphore also publishes the task results to the emulation thread */
+        SDL_SemPost(l_task_done);
+    }
+
+    return 0;
+}
+
+int rsp_worker_init(void)
+{
+    if (l_thread != NULL)
+        return 0;
+
+    l_quit = 0;
+    l_task_start = SDL_CreateSemaphore(0);
+    l_task_done = SDL_CreateSemaphore(0);
+    if (l_task_start == NULL || l_task_done == NULL) {
+        DebugMessage(M64MSG_ERROR, "Could not create RSP worker semaphores");
+        rsp_worker_shutdown();
+        return -1;
+    }
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+    l_thread = SDL_CreateThread(rsp_worker_thread, "m64prsp", NULL);
+#else
+    l_thread = SDL_CreateThread(rsp_worker_thread, NULL);
+#endif
+    if (l_thread == NULL) {
+        DebugMessage(M64MSG_ERROR, "Could not create RSP worker thread");
+        rsp_worker_shutdown();
+        return -1;
+    }
+
+    DebugMessage(M64MSG_INFO, "RSP tasks run on a worker thread");
+    return 0;
+}
+
+void rsp_worker_shutdown(void)
+{
+    int status;
+
+    if (l_thread != NULL) {
+        l_quit = 1;
+        SDL_SemPost(l_task_start);
+        SDL_WaitThread(l_thread, &status);
+        l_thread = NULL;
+    }
+
+    if (l_task_start != NULL) {
+        SDL_DestroySemaphore(l_task_start);
+        l_task_start = NULL;
+    }
+    if (l_task_done != NULL) {
+        SDL_DestroySemaphore(l_task_done);
+        l_task_done = NULL;
+    }
+}
+
+void rsp_worker_after_fork(void)
+{
+    /* Only the forking thread survives in the child: forget about the
+     * parent's worker (no task is in flight at a fork) and start another one. */
+    if (l_thread == NULL)
+        return;
+
+    l_thread = NULL;
+    l_task_start = NULL;
+    l_task_done = NULL;
+    rsp_worker_init();
+}
+
+void rsp_worker_start_task(void)
+{
+    /* without a worker, the task simply runs in place */
+    if (l_thread == NULL) {
+        rsp.doRspCycles(0xffffffff);
+        return;
+    }
+
+    SDL_SemPost(l_task_start);
+}
+
+void rsp_worker_wait_task(void)
+{
+    if (l_thread != NULL)
+        SDL_SemWait(l_task_done);
+}
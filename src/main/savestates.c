@@ -189,6 +189,7 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
     unsigned int version;
     int i;
     uint32_t FCR31;
+    int tlb_lut_failed;
 
     size_t savestateSize;
     unsigned char *savestateData, *curr;
@@ -426,8 +427,18 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
     /* by default, reset flashram state here and load it later if available */
     poweron_flashram(&dev->cart.flashram);
 
-    COPYARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
-    COPYARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    tlb_lut_failed = 0;
+    tlb_lut_clear(&dev->r4300.cp0.tlb.LUT_r);
+    for (i = 0; i < 0x100000; ++i)
+        tlb_lut_failed |= tlb_lut_set(&dev->r4300.cp0.tlb.LUT_r, i, GETDATA(curr, uint32_t));
+    tlb_lut_clear(&dev->r4300.cp0.tlb.LUT_w);
+    for (i = 0; i < 0x100000; ++i)
+        tlb_lut_failed |= tlb_lut_set(&dev->r4300.cp0.tlb.LUT_w, i, GETDATA(curr, uint32_t));
+    if (tlb_lut_failed)
+    {
+        main_message(M64MSG_ERROR, OSD_BOTTOM_LEFT, "Insufficient memory to restore the TLB, stopping emulation.");
+        main_stop();
+    }
 
     *r4300_llbit(&dev->r4300) = GETDATA(curr, uint32_t);
     COPYARRAY(r4300_regs(&dev->r4300), curr, int64_t, 32);
@@ -958,6 +969,7 @@ static int savestates_load_pj64(struct device* dev,
     unsigned int vi_timer, SaveRDRAMSize;
     size_t i;
     uint32_t FCR31;
+    int tlb_lut_failed = 0;
 
     unsigned char header[8];
     unsigned char RomHeader[0x40];
@@ -1172,8 +1184,8 @@ static int savestates_load_pj64(struct device* dev,
     dev->si.regs[SI_STATUS_REG]         = GETDATA(curr, uint32_t);
 
     // tlb
-    memset(dev->r4300.cp0.tlb.LUT_r, 0, 0x400000);
-    memset(dev->r4300.cp0.tlb.LUT_w, 0, 0x400000);
+    tlb_lut_clear(&dev->r4300.cp0.tlb.LUT_r);
+    tlb_lut_clear(&dev->r4300.cp0.tlb.LUT_w);
     for (i=0; i < 32; i++)
     {
         unsigned int MyPageMask, MyEntryHi, MyEntryLo0, MyEntryLo1;
@@ -1209,7 +1221,12 @@ static int savestates_load_pj64(struct device* dev,
           (dev->r4300.cp0.tlb.entries[i].mask << 12) + 0xFFF;
         dev->r4300.cp0.tlb.entries[i].phys_odd = dev->r4300.cp0.tlb.entries[i].pfn_odd << 12;
 
-        tlb_map(&dev->r4300.cp0.tlb, i);
+        tlb_lut_failed |= tlb_map(&dev->r4300.cp0.tlb, i);
+    }
+    if (tlb_lut_failed)
+    {
+        main_message(M64MSG_ERROR, OSD_BOTTOM_LEFT, "Insufficient memory to restore the TLB, stopping emulation.");
+        main_stop();
     }
 
     // pif ram
@@ -1395,6 +1412,8 @@ int savestates_load(void)
     char *filepath = NULL;
     int ret = 0;
 
+    rsp_task_sync(&g_dev.sp);
+
     if (fname == NULL) // For slots, autodetect the savestate type
     {
         // try M64P type first
@@ -1702,8 +1721,10 @@ static int savestates_save_m64p(const struct device* dev, char *filepath)
     PUTDATA(curr, int32_t, dev->cart.use_flashram);
     curr += 4+8+4+4; // Here used to be flashram state
 
-    PUTARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
-    PUTARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    for (i = 0; i < 0x100000; ++i)
+        PUTDATA(curr, uint32_t, tlb_lut_get(&dev->r4300.cp0.tlb.LUT_r, i));
+    for (i = 0; i < 0x100000; ++i)
+        PUTDATA(curr, uint32_t, tlb_lut_get(&dev->r4300.cp0.tlb.LUT_w, i));
 
     /* OK to cast away const qualifier */
     PUTDATA(curr, uint32_t, *r4300_llbit((struct r4300_core*)&dev->r4300));
@@ -2144,6 +2165,8 @@ int savestates_save(void)
     int ret = 0;
     const struct device* dev = &g_dev;
 
+    rsp_task_sync(&g_dev.sp);
+
     /* Can only save PJ64 savestates on VI / COMPARE interrupt.
        Otherwise try again in a little while. */
     if ((type == savestates_type_pj64_zip ||
@@ -26,6 +26,8 @@
 #if !defined (OSAL_FILES_H)
 #define OSAL_FILES_H
 
+#include <stddef.h>
+
 /* some file-related preprocessor definitions */
 #if defined(WIN32) && !defined(__MINGW32__)
   #include <io.h> // For _unlink()
@@ -57,5 +59,16 @@ extern const char * osal_get_user_configpath(void);
 extern const char * osal_get_user_datapath(void);
 extern const char * osal_get_user_cachepath(void);
 
+/* Map a whole file in memory, read-only for the file itself but writable
+ * (copy-on-write) for the caller. On success the mapping size is stored in
+ * *size. Returns NULL on failure. */
+extern void * osal_file_map(const char *filepath, size_t *size);
+extern void osal_file_unmap(void *addr, size_t size);
+
+/* Move a file over another one, replacing it if it exists.
+ * Readers of dstpath see either the old or the new file, never neither.
+ * Returns zero on success, nonzero on failure. */
+extern int osal_file_replace(const char *srcpath, const char *dstpath);
+
 #endif /* OSAL_FILES_H */
 
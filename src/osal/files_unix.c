@@ -23,10 +23,12 @@
  * functions
  */
 
+#include <fcntl.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -232,4 +234,38 @@ const char * osal_get_user_cachepath(void)
     return NULL;
 }
 
+void * osal_file_map(const char *filepath, size_t *size)
+{
+    struct stat fileinfo;
+    void *addr;
+    int fd;
+
+    fd = open(filepath, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &fileinfo) != 0 || fileinfo.st_size <= 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    addr = mmap(NULL, (size_t) fileinfo.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return NULL;
 
+    *size = (size_t) fileinfo.st_size;
+    return addr;
+}
+
+void osal_file_unmap(void *addr, size_t size)
+{
+    if (addr != NULL)
+        munmap(addr, size);
+}
+
+int osal_file_replace(const char *srcpath, const char *dstpath)
+{
+    return rename(srcpath, dstpath);
+}
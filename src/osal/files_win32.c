@@ -30,6 +30,7 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <windows.h>
 
 #include "api/callbacks.h"
 #include "api/m64p_types.h"
@@ -204,4 +205,44 @@ const char * osal_get_user_cachepath(void)
     return osal_get_user_configpath();
 }
 
+void * osal_file_map(const char *filepath, size_t *size)
+{
+    HANDLE file, mapping;
+    LARGE_INTEGER filesize;
+    void *addr = NULL;
+
+    file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    if (!GetFileSizeEx(file, &filesize) || filesize.QuadPart <= 0)
+    {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+        return NULL;
+
+    addr = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    if (addr == NULL)
+        return NULL;
 
+    *size = (size_t) filesize.QuadPart;
+    return addr;
+}
+
+void osal_file_unmap(void *addr, size_t size)
+{
+    if (addr != NULL)
+        UnmapViewOfFile(addr);
+}
+
+int osal_file_replace(const char *srcpath, const char *dstpath)
+{
+    /* rename() fails on windows when the destination exists */
+    return MoveFileExA(srcpath, dstpath, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+}
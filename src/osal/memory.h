@@ -0,0 +1,57 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-core - osal/memory.h                                      *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* This file contains the declarations for the OS-dependent allocation of
+ * large memory regions, backed by large (2MB) pages when the host allows it
+ */
+
+#if !defined (OSAL_MEMORY_H)
+#define OSAL_MEMORY_H
+
+#include <stddef.h>
+
+enum osal_large_pages
+{
+    OSAL_LARGE_PAGES_OFF = 0,
+    /* transparent huge pages (madvise) */
+    OSAL_LARGE_PAGES_TRANSPARENT = 1,
+    /* reserved huge pages (hugetlbfs, or large pages on Windows),
+     * falling back to transparent huge pages. On Windows this needs the
+     * "Lock pages in memory" user right, and only applies to regions of
+     * up to 64MB. */
+    OSAL_LARGE_PAGES_RESERVED = 2
+};
+
+/* Selects how the following allocations use large pages */
+extern void osal_set_large_pages(int mode);
+
+/* Allocates size bytes of zero-filled, read-write memory, aligned to at
+ * least 64KB. The size of the pages backing it is stored in *page_size if
+ * page_size isn't NULL. Returns NULL on failure. */
+extern void * osal_alloc_pages(size_t size, size_t *page_size);
+extern void osal_free_pages(void *addr, size_t size);
+
+/* Asks for large pages to back an existing region, such as a static array.
+ * Only the part of the region covering whole large pages can use them.
+ * Returns the size of the pages backing the region. */
+extern size_t osal_advise_large_pages(void *addr, size_t size);
+
+#endif /* OSAL_MEMORY_H */
@@ -0,0 +1,141 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-core - osal/memory_unix.c                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* This file contains the definitions for the unix-specific allocation of
+ * large memory regions
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "memory.h"
+
+enum { LARGE_PAGE_SIZE = 2 * 1024 * 1024 };
+
+static int l_LargePages = OSAL_LARGE_PAGES_TRANSPARENT;
+
+void osal_set_large_pages(int mode)
+{
+    l_LargePages = mode;
+}
+
+static size_t small_page_size(void)
+{
+    long size = sysconf(_SC_PAGESIZE);
+    return (size > 0) ? (size_t)size : 4096;
+}
+
+/* Transparent huge pages are only used if they are enabled for madvised
+ * regions ("[always]" or "[madvise]", not "[never]") */
+static int transparent_huge_pages_enabled(void)
+{
+#if defined(MADV_HUGEPAGE)
+    static int enabled = -1;
+    char mode[64];
+    FILE *f;
+
+    if (enabled < 0)
+    {
+        enabled = 0;
+        f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+        if (f != NULL)
+        {
+            if (fgets(mode, sizeof(mode), f) != NULL)
+                enabled = (strstr(mode, "[never]") == NULL);
+            fclose(f);
+        }
+    }
+
+    return enabled;
+#else
+    return 0;
+#endif
+}
+
+size_t osal_advise_large_pages(void *addr, size_t size)
+{
+#if defined(MADV_HUGEPAGE)
+    uintptr_t begin = ((uintptr_t)addr + LARGE_PAGE_SIZE - 1) & ~(uintptr_t)(LARGE_PAGE_SIZE - 1);
+    uintptr_t end = ((uintptr_t)addr + size) & ~(uintptr_t)(LARGE_PAGE_SIZE - 1);
+
+    if (l_LargePages != OSAL_LARGE_PAGES_OFF && end > begin
+        && transparent_huge_pages_enabled()
+        && madvise((void *)begin, end - begin, MADV_HUGEPAGE) == 0)
+        return LARGE_PAGE_SIZE;
+#endif
+
+    return small_page_size();
+}
+
+void * osal_alloc_pages(size_t size, size_t *page_size)
+{
+    uint8_t *addr;
+    size_t head, tail;
+    size_t pages = small_page_size();
+
+    size = (size + pages - 1) & ~(pages - 1);
+
+#if defined(MAP_HUGETLB)
+    if (l_LargePages == OSAL_LARGE_PAGES_RESERVED && (size & (LARGE_PAGE_SIZE - 1)) == 0)
+    {
+        addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (addr != MAP_FAILED)
+        {
+            if (page_size != NULL)
+                *page_size = LARGE_PAGE_SIZE;
+            return addr;
+        }
+    }
+#endif
+
+    /* over-allocate so that the region can be aligned on a large page */
+    addr = mmap(NULL, size + LARGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+        return NULL;
+
+    head = (LARGE_PAGE_SIZE - ((uintptr_t)addr & (LARGE_PAGE_SIZE - 1))) & (LARGE_PAGE_SIZE - 1);
+    tail = LARGE_PAGE_SIZE - head;
+    if (head != 0)
+        munmap(addr, head);
+    if (tail != 0)
+        munmap(addr + head + size, tail);
+    addr += head;
+
+    pages = osal_advise_large_pages(addr, size);
+    if (page_size != NULL)
+        *page_size = pages;
+
+    return addr;
+}
+
+void osal_free_pages(void *addr, size_t size)
+{
+    size_t pages = small_page_size();
+
+    if (addr == NULL)
+        return;
+
+    /* hugetlbfs mappings are unmapped in whole large pages anyway */
+    munmap(addr, (size + pages - 1) & ~(pages - 1));
+}
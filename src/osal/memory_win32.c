@@ -0,0 +1,123 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-core - osal/memory_win32.c                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* This file contains the definitions for the windows-specific allocation of
+ * large memory regions
+ */
+
+#include <windows.h>
+
+#include "memory.h"
+
+/* Large pages are committed and locked as a whole. Larger regions, like
+ * the sparse 512MB full mem base, stay on small pages so that the parts the
+ * guest never touches aren't pinned in memory. */
+#define LARGE_PAGES_MAX_SIZE (64 * 1024 * 1024)
+
+static int l_LargePages = OSAL_LARGE_PAGES_TRANSPARENT;
+/* 0: not tried yet, 1: enabled, -1: not held by the user */
+static int l_LockMemoryPrivilege = 0;
+
+void osal_set_large_pages(int mode)
+{
+    l_LargePages = mode;
+}
+
+static size_t small_page_size(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+/* Windows has no transparent large pages: the regions which exist already
+ * stay on small pages */
+size_t osal_advise_large_pages(void *addr, size_t size)
+{
+    (void)addr;
+    (void)size;
+    return small_page_size();
+}
+
+/* MEM_LARGE_PAGES needs SeLockMemoryPrivilege ("Lock pages in memory"),
+ * which has to be enabled in the process token even when the user holds it */
+static int enable_lock_memory_privilege(void)
+{
+    TOKEN_PRIVILEGES privileges;
+    HANDLE token;
+    BOOL ok;
+
+    if (l_LockMemoryPrivilege != 0)
+        return l_LockMemoryPrivilege > 0;
+
+    l_LockMemoryPrivilege = -1;
+
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+        return 0;
+
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    ok = LookupPrivilegeValueA(NULL, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)
+      && AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL)
+      /* succeeds with ERROR_NOT_ALL_ASSIGNED when the user lacks it */
+      && GetLastError() == ERROR_SUCCESS;
+
+    CloseHandle(token);
+
+    if (ok)
+        l_LockMemoryPrivilege = 1;
+
+    return ok;
+}
+
+void * osal_alloc_pages(size_t size, size_t *page_size)
+{
+    SIZE_T large = GetLargePageMinimum();
+    void *addr;
+
+    /* large pages are committed and locked in memory as a whole,
+     * so they are reserved mode only */
+    if (l_LargePages == OSAL_LARGE_PAGES_RESERVED && large != 0 && (size % large) == 0
+     && size <= LARGE_PAGES_MAX_SIZE && enable_lock_memory_privilege())
+    {
+        addr = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (addr != NULL)
+        {
+            if (page_size != NULL)
+                *page_size = large;
+            return addr;
+        }
+    }
+
+    /* allocations are aligned on the 64KB allocation granularity */
+    addr = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (addr != NULL && page_size != NULL)
+        *page_size = small_page_size();
+
+    return addr;
+}
+
+void osal_free_pages(void *addr, size_t size)
+{
+    (void)size;
+    if (addr != NULL)
+        VirtualFree(addr, 0, MEM_RELEASE);
+}
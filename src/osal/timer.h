@@ -0,0 +1,45 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-core - osal/timer.h                                       *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* This file contains the declarations for the OS-dependent high resolution
+ * timing functions
+ */
+
+#if !defined (OSAL_TIMER_H)
+#define OSAL_TIMER_H
+
+#include <stdint.h>
+
+/* Returns the time of a monotonic clock, in nanoseconds */
+extern int64_t osal_time_ns(void);
+
+/* Set up and release what osal_sleep_until_ns needs for an accurate OS
+ * sleep, around the emulation loop */
+extern void osal_timer_begin(void);
+extern void osal_timer_end(void);
+
+/* Sleeps until the monotonic clock reaches deadline. The OS sleep wakes up
+ * a little early, and the last stretch is spent spinning, so that the
+ * deadline isn't overshot by the scheduler latency. */
+extern void osal_sleep_until_ns(int64_t deadline);
+
+#endif /* OSAL_TIMER_H */
+
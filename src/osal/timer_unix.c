@@ -0,0 +1,74 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-core - osal/timer_unix.c                                  *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* This file contains the definitions for the unix-specific high resolution
+ * timing functions
+ */
+
+#include <errno.h>
+#include <time.h>
+
+#include "timer.h"
+
+/* how long before the deadline the OS sleep ends */
+enum { SPIN_NS = 200000 };
+
+int64_t osal_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* the OS sleep is already accurate */
+void osal_timer_begin(void)
+{
+}
+
+void osal_timer_end(void)
+{
+}
+
+void osal_sleep_until_ns(int64_t deadline)
+{
+    int64_t wake = deadline - SPIN_NS;
+
+    if (osal_time_ns() < wake)
+    {
+        struct timespec ts;
+#if defined(__APPLE__)
+        /* no clock_nanosleep: sleep for the remaining time instead */
+        int64_t delay = wake - osal_time_ns();
+        if (delay > 0)
+        {
+            ts.tv_sec = (time_t)(delay / 1000000000);
+            ts.tv_nsec = (long)(delay % 1000000000);
+            while (nanosleep(&ts, &ts) == -1 && errno == EINTR);
+        }
+#else
+        ts.tv_sec = (time_t)(wake / 1000000000);
+        ts.tv_nsec = (long)(wake % 1000000000);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+#endif
+    }
+
+    while (osal_time_ns() < deadline);
+}
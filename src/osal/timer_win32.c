@@ -0,0 +1,108 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-core - osal/timer_win32.c                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* This file contains the definitions for the windows-specific high resolution
+ * timing functions
+ */
+
+#include <windows.h>
+#include <mmsystem.h>
+
+#include "timer.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+/* how long before the deadline the OS sleep ends: a high resolution
+ * waitable timer is accurate to about 0.5ms, Sleep has a 1ms granularity
+ * at best (with timeBeginPeriod(1)) and may oversleep by as much */
+enum { TIMER_SPIN_NS = 500000, SLEEP_SPIN_NS = 2000000 };
+
+/* high resolution waitable timer (Windows 10 1803 and later) */
+static HANDLE l_Timer = NULL;
+/* otherwise, whether timeBeginPeriod(1) is in effect for Sleep */
+static int l_TimerPeriod = 0;
+
+static int64_t counter_frequency(void)
+{
+    static LARGE_INTEGER freq = { 0 };
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    return freq.QuadPart;
+}
+
+int64_t osal_time_ns(void)
+{
+    LARGE_INTEGER counter;
+    int64_t freq = counter_frequency();
+
+    QueryPerformanceCounter(&counter);
+    return (counter.QuadPart / freq) * 1000000000
+         + (counter.QuadPart % freq) * 1000000000 / freq;
+}
+
+void osal_timer_begin(void)
+{
+    if (l_Timer != NULL || l_TimerPeriod)
+        return;
+
+    l_Timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+    /* the default 15.6ms timer resolution would make every Sleep late */
+    if (l_Timer == NULL && timeBeginPeriod(1) == TIMERR_NOERROR)
+        l_TimerPeriod = 1;
+}
+
+void osal_timer_end(void)
+{
+    if (l_Timer != NULL)
+    {
+        CloseHandle(l_Timer);
+        l_Timer = NULL;
+    }
+
+    if (l_TimerPeriod)
+    {
+        timeEndPeriod(1);
+        l_TimerPeriod = 0;
+    }
+}
+
+void osal_sleep_until_ns(int64_t deadline)
+{
+    int64_t delay = deadline - ((l_Timer != NULL) ? TIMER_SPIN_NS : SLEEP_SPIN_NS) - osal_time_ns();
+
+    if (l_Timer != NULL && delay > 0)
+    {
+        LARGE_INTEGER due;
+
+        /* negative due times are relative, in 100ns units */
+        due.QuadPart = -(delay / 100);
+        if (SetWaitableTimer(l_Timer, &due, 0, NULL, NULL, FALSE))
+            WaitForSingleObject(l_Timer, INFINITE);
+    }
+    else if (delay >= 1000000)
+        Sleep((DWORD)(delay / 1000000));
+
+    while (osal_time_ns() < deadline)
+        YieldProcessor();
+}
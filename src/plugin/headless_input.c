@@ -0,0 +1,185 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - headless_input.c                                        *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define M64P_CORE_PROTOTYPES 1
+#include "api/callbacks.h"
+#include "api/m64p_config.h"
+#include "api/m64p_types.h"
+#include "headless_input.h"
+#include "main/main.h"
+#include "plugin.h"
+
+struct input_queue
+{
+    uint32_t *buttons;
+    size_t size;
+    size_t capacity;
+    size_t pos;
+    uint32_t held;
+};
+
+static struct input_queue l_Queues[4];
+
+m64p_error headlessinput_PluginGetVersion(m64p_plugin_type *PluginType, int *PluginVersion,
+                                          int *APIVersion, const char **PluginNamePtr, int *Capabilities)
+{
+    if (PluginType != NULL)
+        *PluginType = M64PLUGIN_INPUT;
+
+    if (PluginVersion != NULL)
+        *PluginVersion = 0x00010000;
+
+    if (APIVersion != NULL)
+        *APIVersion = INPUT_API_VERSION;
+
+    if (PluginNamePtr != NULL)
+        *PluginNamePtr = "Mupen64Plus-HeadlessInput";
+
+    if (Capabilities != NULL)
+        *Capabilities = 0;
+
+    return M64ERR_SUCCESS;
+}
+
+void headlessinput_InitiateControllers(CONTROL_INFO ControlInfo)
+{
+    int i;
+    int count = ConfigGetParamInt(g_CoreConfig, "HeadlessControllers");
+
+    for (i = 0; i < 4 && i < count; ++i)
+        ControlInfo.Controls[i].Present = 1;
+}
+
+void headlessinput_GetKeys(int Control, BUTTONS *Keys)
+{
+    const struct input_queue *q = &l_Queues[Control & 3];
+
+    Keys->Value = (q->pos < q->size) ? q->buttons[q->pos] : q->held;
+}
+
+void headlessinput_ControllerCommand(int Control, unsigned char *Command)
+{
+}
+
+void headlessinput_ReadController(int Control, unsigned char *Command)
+{
+}
+
+int headlessinput_RomOpen(void)
+{
+    return 1;
+}
+
+void headlessinput_RomClosed(void)
+{
+    int i;
+
+    for (i = 0; i < 4; ++i)
+    {
+        free(l_Queues[i].buttons);
+        memset(&l_Queues[i], 0, sizeof(l_Queues[i]));
+    }
+}
+
+void headlessinput_SDL_KeyDown(int keymod, int keysym)
+{
+}
+
+void headlessinput_SDL_KeyUp(int keymod, int keysym)
+{
+}
+
+void headlessinput_RenderCallback(void)
+{
+}
+
+int headlessinput_queue(int Control, const uint32_t *Buttons, size_t Frames)
+{
+    struct input_queue *q;
+
+    if (Control < 0 || Control > 3)
+        return 0;
+
+    q = &l_Queues[Control];
+
+    /* drop the frames already played back before growing the queue */
+    if (q->pos > 0)
+    {
+        memmove(q->buttons, q->buttons + q->pos, (q->size - q->pos) * sizeof(uint32_t));
+        q->size -= q->pos;
+        q->pos = 0;
+    }
+
+    if (q->size + Frames > q->capacity)
+    {
+        size_t capacity = (q->capacity != 0) ? q->capacity : 64;
+        uint32_t *buttons;
+
+        while (capacity < q->size + Frames)
+            capacity *= 2;
+
+        buttons = (uint32_t *) realloc(q->buttons, capacity * sizeof(uint32_t));
+        if (buttons == NULL)
+        {
+            DebugMessage(M64MSG_ERROR, "Headless input: couldn't queue %u frames for controller %i", (unsigned int) Frames, Control + 1);
+            return 0;
+        }
+
+        q->buttons = buttons;
+        q->capacity = capacity;
+    }
+
+    memcpy(q->buttons + q->size, Buttons, Frames * sizeof(uint32_t));
+    q->size += Frames;
+    return 1;
+}
+
+void headlessinput_clear(int Control)
+{
+    struct input_queue *q;
+
+    if (Control < 0 || Control > 3)
+        return;
+
+    q = &l_Queues[Control];
+    q->size = 0;
+    q->pos = 0;
+    q->held = 0;
+}
+
+void headlessinput_new_frame(void)
+{
+    int i;
+
+    for (i = 0; i < 4; ++i)
+    {
+        struct input_queue *q = &l_Queues[i];
+
+        if (q->pos < q->size)
+        {
+            q->held = q->buttons[q->pos];
+            ++q->pos;
+        }
+    }
+}
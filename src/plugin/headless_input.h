@@ -0,0 +1,50 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - headless_input.h                                        *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#if !defined(HEADLESS_INPUT_H)
+#define HEADLESS_INPUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "api/m64p_plugin.h"
+#include "api/m64p_types.h"
+
+extern m64p_error headlessinput_PluginGetVersion(m64p_plugin_type *PluginType, int *PluginVersion,
+                                                 int *APIVersion, const char **PluginNamePtr, int *Capabilities);
+extern void headlessinput_ControllerCommand(int Control, unsigned char *Command);
+extern void headlessinput_GetKeys(int Control, BUTTONS *Keys);
+extern void headlessinput_InitiateControllers(CONTROL_INFO ControlInfo);
+extern void headlessinput_ReadController(int Control, unsigned char *Command);
+extern int  headlessinput_RomOpen(void);
+extern void headlessinput_RomClosed(void);
+extern void headlessinput_SDL_KeyDown(int keymod, int keysym);
+extern void headlessinput_SDL_KeyUp(int keymod, int keysym);
+extern void headlessinput_RenderCallback(void);
+
+/* The headless input plays back per-frame BUTTONS values queued in memory.
+ * Once a controller's queue runs out, its last value is held. */
+extern int  headlessinput_queue(int Control, const uint32_t *Buttons, size_t Frames);
+extern void headlessinput_clear(int Control);
+extern void headlessinput_new_frame(void);
+
+#endif /* HEADLESS_INPUT_H */
+
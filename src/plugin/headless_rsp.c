@@ -0,0 +1,89 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - headless_rsp.c                                          *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdlib.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "device/rcp/mi/mi_controller.h"
+#include "device/rcp/rsp/rsp_core.h"
+#include "headless_rsp.h"
+#include "plugin.h"
+
+/* The headless RSP only implements the task protocol: it ends each task
+ * the way a real microcode would, without running it (see skip_rsp_task).
+ * Display lists are dropped (as if fully synced by the RDP), and so are
+ * audio lists. */
+
+static RSP_INFO l_RspInfo;
+static int l_WarnedTaskType = 0;
+
+m64p_error headlessrsp_PluginGetVersion(m64p_plugin_type *PluginType, int *PluginVersion,
+                                        int *APIVersion, const char **PluginNamePtr, int *Capabilities)
+{
+    if (PluginType != NULL)
+        *PluginType = M64PLUGIN_RSP;
+
+    if (PluginVersion != NULL)
+        *PluginVersion = 0x00010000;
+
+    if (APIVersion != NULL)
+        *APIVersion = RSP_API_VERSION;
+
+    if (PluginNamePtr != NULL)
+        *PluginNamePtr = "Mupen64Plus-HeadlessRSP";
+
+    if (Capabilities != NULL)
+        *Capabilities = 0;
+
+    return M64ERR_SUCCESS;
+}
+
+unsigned int headlessrsp_DoRspCycles(unsigned int Cycles)
+{
+    const uint32_t* dmem = (const uint32_t*)l_RspInfo.DMEM;
+    uint32_t type = dmem[OSTASK_TYPE/4];
+    uint32_t mi_intr = *l_RspInfo.MI_INTR_REG;
+
+    if (type != M_GFXTASK && type != M_AUDTASK && !l_WarnedTaskType)
+    {
+        DebugMessage(M64MSG_WARNING, "Headless RSP: ending task of unsupported type %u without running it", type);
+        l_WarnedTaskType = 1;
+    }
+
+    if (skip_rsp_task(dmem, l_RspInfo.SP_STATUS_REG, l_RspInfo.MI_INTR_REG) & RSP_TASK_FULL_SYNC)
+        *l_RspInfo.MI_INTR_REG |= MI_INTR_DP;
+
+    if (*l_RspInfo.MI_INTR_REG & ~mi_intr & MI_INTR_SP)
+        l_RspInfo.CheckInterrupts();
+
+    return Cycles;
+}
+
+void headlessrsp_InitiateRSP(RSP_INFO Rsp_Info, unsigned int * CycleCount)
+{
+    l_RspInfo = Rsp_Info;
+    l_WarnedTaskType = 0;
+}
+
+void headlessrsp_RomClosed(void)
+{
+}
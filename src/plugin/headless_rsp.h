@@ -0,0 +1,35 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - headless_rsp.h                                          *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2021 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#if !defined(HEADLESS_RSP_H)
+#define HEADLESS_RSP_H
+
+#include "api/m64p_plugin.h"
+#include "api/m64p_types.h"
+
+extern m64p_error headlessrsp_PluginGetVersion(m64p_plugin_type *PluginType, int *PluginVersion,
+                                               int *APIVersion, const char **PluginNamePtr, int *Capabilities);
+extern unsigned int headlessrsp_DoRspCycles(unsigned int Cycles);
+extern void headlessrsp_InitiateRSP(RSP_INFO Rsp_Info, unsigned int *CycleCount);
+extern void headlessrsp_RomClosed(void);
+
+#endif /* HEADLESS_RSP_H */
+
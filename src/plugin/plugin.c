@@ -24,8 +24,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#define M64P_CORE_PROTOTYPES 1
 #include "api/callbacks.h"
 #include "api/m64p_common.h"
+#include "api/m64p_config.h"
 #include "api/m64p_plugin.h"
 #include "api/m64p_types.h"
 #include "device/memory/memory.h"
@@ -38,6 +40,8 @@
 #include "dummy_input.h"
 #include "dummy_rsp.h"
 #include "dummy_video.h"
+#include "headless_input.h"
+#include "headless_rsp.h"
 #include "main/main.h"
 #include "main/rom.h"
 #include "main/version.h"
@@ -111,6 +115,26 @@ static const rsp_plugin_functions dummy_rsp = {
     dummyrsp_RomClosed
 };
 
+static const input_plugin_functions headless_input = {
+    headlessinput_PluginGetVersion,
+    headlessinput_ControllerCommand,
+    headlessinput_GetKeys,
+    headlessinput_InitiateControllers,
+    headlessinput_ReadController,
+    headlessinput_RomClosed,
+    headlessinput_RomOpen,
+    headlessinput_SDL_KeyDown,
+    headlessinput_SDL_KeyUp,
+    headlessinput_RenderCallback
+};
+
+static const rsp_plugin_functions headless_rsp = {
+    headlessrsp_PluginGetVersion,
+    headlessrsp_DoRspCycles,
+    headlessrsp_InitiateRSP,
+    headlessrsp_RomClosed
+};
+
 static GFX_INFO gfx_info;
 static AUDIO_INFO audio_info;
 static CONTROL_INFO control_info;
@@ -485,7 +509,10 @@ static m64p_error plugin_start_rsp(void)
     rsp_info.RDRAM = (unsigned char *)mem_base_u32(g_mem_base, MM_RDRAM_DRAM);
     rsp_info.DMEM = (unsigned char *)mem_base_u32(g_mem_base, MM_RSP_MEM);
     rsp_info.IMEM = (unsigned char *)mem_base_u32(g_mem_base, MM_RSP_MEM + 0x1000);
-    rsp_info.MI_INTR_REG = &g_dev.mi.regs[MI_INTR_REG];
+    /* a copy of the MI register, merged back by the core once the task is
+     * over, so that tasks on the RSP worker don't race with the emulation
+     * thread (see do_SP_Task) */
+    rsp_info.MI_INTR_REG = &g_dev.sp.mi_intr;
     rsp_info.SP_MEM_ADDR_REG = &g_dev.sp.regs[SP_MEM_ADDR_REG];
     rsp_info.SP_DRAM_ADDR_REG = &g_dev.sp.regs[SP_DRAM_ADDR_REG];
     rsp_info.SP_RD_LEN_REG = &g_dev.sp.regs[SP_RD_LEN_REG];
@@ -560,8 +587,53 @@ m64p_error plugin_start(m64p_plugin_type type)
     return M64ERR_INTERNAL;
 }
 
+/* The headless profile stands in for the plugins the front-end didn't attach.
+ * The dummy video and audio plugins already are free: no GL context, and
+ * audio samples are dropped where they are. Input and RSP have headless
+ * plugins of their own, which play back queued inputs and end RSP tasks. */
+static void plugin_use_headless(void)
+{
+    if (!l_InputAttached)
+    {
+        input = headless_input;
+        plugin_start_input();
+    }
+
+    if (!l_RspAttached)
+    {
+        rsp = headless_rsp;
+        plugin_start_rsp();
+    }
+
+    DebugMessage(M64MSG_INFO, "Headless plugins: video %s, audio %s, input %s, RSP %s",
+                 l_GfxAttached ? "attached" : "built-in",
+                 l_AudioAttached ? "attached" : "built-in",
+                 l_InputAttached ? "attached" : "built-in",
+                 l_RspAttached ? "attached" : "built-in");
+}
+
+/* Whether the core runs on the headless profile alone: no plugin attached by
+ * the front-end, so no plugin thread, GL context or audio device exists */
+int plugin_is_headless(void)
+{
+    return ConfigGetParamBool(g_CoreConfig, "HeadlessPlugins")
+        && !l_GfxAttached && !l_AudioAttached && !l_InputAttached && !l_RspAttached;
+}
+
 m64p_error plugin_check(void)
 {
+    if (ConfigGetParamBool(g_CoreConfig, "HeadlessPlugins"))
+    {
+        plugin_use_headless();
+        return M64ERR_SUCCESS;
+    }
+
+    /* back to the dummy plugins after a headless run */
+    if (!l_InputAttached)
+        input = dummy_input;
+    if (!l_RspAttached)
+        rsp = dummy_rsp;
+
     if (!l_GfxAttached)
         DebugMessage(M64MSG_WARNING, "No video plugin attached.  There will be no video output.");
     if (!l_RspAttached)
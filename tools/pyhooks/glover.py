@@ -0,0 +1,33 @@
+import os
+
+from mupen_util import *
+
+# Glover (USA) debugging aids, enabled through environment variables
+
+FN_FLUSH = 0x80139D70
+EMULATED_STDOUT = 0x8025D578
+
+if os.environ.get("GLOVER_STDOUT") is not None:
+    mupen_core.registerCallHookPrint(FN_FLUSH, EMULATED_STDOUT)
+
+if os.environ.get("GLOVER_DUMP_LEV_OFFSETS") is not None:
+    @pcHook(0x801822CC)
+    def dumpLevelCommand(c):
+        # Top of landscape parsing hot loop
+        base_addr = c.read_u32(u32(c.regs[SP]) + 0x3c)
+        level_id = c.read_u8(0x801e7531)
+        print("level {:d} cmd +0x{:x} = 0x{:04x}".format(
+            level_id, u32(c.regs[V0] - base_addr - 2), u32(c.regs[A0]) >> 16))
+
+    @pcHook(0x80182EAC)
+    def levelParsed(c):
+        # Bottom of landscape parsing function
+        print("level parsing complete", flush=True)
+
+if os.environ.get("GLOVER_LEVEL_ID") is not None:
+    level_id = int(os.environ["GLOVER_LEVEL_ID"])
+
+    @pcHook(0x8011D88C)
+    def forceLevel(c):
+        # Top of level loading machinery
+        c.regs[A0] = level_id